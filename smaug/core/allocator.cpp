@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "smaug/core/allocator.h"
+#include "smaug/operators/common.h"
+#include "smaug/utility/utils.h"
+
+namespace smaug {
+
+std::shared_ptr<void> ArenaAllocator::allocate(size_t bytes) {
+    bytes = next_multiple(bytes, CACHELINE_SIZE);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!block || blockOffset + bytes > currBlockSize) {
+        // Start a new block. Storage larger than a block gets a block of its
+        // own.
+        currBlockSize = std::max(blockSize, bytes);
+        block = std::shared_ptr<char>(
+                reinterpret_cast<char*>(malloc_aligned(currBlockSize, false)),
+                free);
+        blockOffset = 0;
+        numBlocks++;
+    }
+    // The aliasing constructor shares the ownership of the block.
+    std::shared_ptr<void> storage(block, block.get() + blockOffset);
+    blockOffset += bytes;
+    bytesAllocated += bytes;
+    return storage;
+}
+
+std::shared_ptr<void> SizeClassPool::allocate(size_t bytes) {
+    int sizeClass = 0;
+    while ((kMinBlockSize << sizeClass) < bytes)
+        sizeClass++;
+    void* ptr = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(freeLists->mutex);
+        if (freeLists->blocks.size() <= sizeClass)
+            freeLists->blocks.resize(sizeClass + 1);
+        std::vector<void*>& freeList = freeLists->blocks[sizeClass];
+        if (!freeList.empty()) {
+            ptr = freeList.back();
+            freeList.pop_back();
+            freeLists->numReused++;
+        } else {
+            freeLists->numBlocks++;
+        }
+    }
+    if (!ptr)
+        ptr = malloc_aligned(kMinBlockSize << sizeClass, false);
+    std::shared_ptr<FreeLists> lists = freeLists;
+    return std::shared_ptr<void>(ptr, [lists, sizeClass](void* ptr) {
+        lists->release(sizeClass, ptr);
+    });
+}
+
+void SizeClassPool::FreeLists::release(int sizeClass, void* ptr) {
+    std::lock_guard<std::mutex> lock(mutex);
+    blocks[sizeClass].push_back(ptr);
+}
+
+SizeClassPool::FreeLists::~FreeLists() {
+    for (auto& freeList : blocks) {
+        for (void* ptr : freeList)
+            free(ptr);
+    }
+}
+
+}  // namespace smaug
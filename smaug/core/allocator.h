@@ -0,0 +1,114 @@
+#ifndef _CORE_ALLOCATOR_H_
+#define _CORE_ALLOCATOR_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace smaug {
+
+/**
+ * Allocator is the interface for allocating the storage of Tensors.
+ *
+ * All storage is cacheline aligned. It is handed out as a shared_ptr, which
+ * returns the storage to its allocator once the last reference to it goes
+ * away, so storage may safely outlive the allocator that created it.
+ */
+class Allocator {
+   public:
+    virtual ~Allocator() {}
+
+    /** Allocates storage of at least the specified size in bytes. */
+    virtual std::shared_ptr<void> allocate(size_t bytes) = 0;
+};
+
+/**
+ * An arena (bump) allocator.
+ *
+ * Allocations are carved out of large blocks, one after another, and are
+ * never reused. All allocations from a block share the block's reference
+ * count, so an allocation costs no call to the system allocator and no
+ * shared_ptr control block. A block is freed once the arena and all the
+ * storage carved out of it are gone.
+ *
+ * This suits Tensors that live as long as the Workspace, like weights.
+ */
+class ArenaAllocator : public Allocator {
+   public:
+    /** The default size of the blocks in bytes. */
+    static constexpr size_t kDefaultBlockSize = 4 << 20;
+
+    ArenaAllocator(size_t _blockSize = kDefaultBlockSize)
+            : blockSize(_blockSize), currBlockSize(0), blockOffset(0),
+              numBlocks(0), bytesAllocated(0) {}
+
+    std::shared_ptr<void> allocate(size_t bytes) override;
+
+    /** Returns the number of blocks allocated so far. */
+    int getNumBlocks() const { return numBlocks; }
+
+    /** Returns the number of bytes handed out so far. */
+    size_t getBytesAllocated() const { return bytesAllocated; }
+
+   protected:
+    /** The size of the blocks in bytes. */
+    size_t blockSize;
+    /** The block allocations are currently carved out of. */
+    std::shared_ptr<char> block;
+    /** The size of the current block in bytes. */
+    size_t currBlockSize;
+    /** The offset of the next allocation in the current block. */
+    size_t blockOffset;
+    int numBlocks;
+    size_t bytesAllocated;
+    std::mutex mutex;
+};
+
+/**
+ * A pool allocator with power-of-two size classes.
+ *
+ * Storage that is released goes back to the free list of its size class,
+ * from where it is handed out again by the next allocation of that class. The
+ * memory held by the pool is freed with it.
+ *
+ * This suits storage that is repeatedly freed and reallocated with the same
+ * sizes, like tiles and the outputs that the Scheduler allocates on demand.
+ */
+class SizeClassPool : public Allocator {
+   public:
+    /** Allocations smaller than this are rounded up to it. */
+    static constexpr size_t kMinBlockSize = 64;
+
+    SizeClassPool() : freeLists(std::make_shared<FreeLists>()) {}
+
+    std::shared_ptr<void> allocate(size_t bytes) override;
+
+    /** Returns the number of blocks obtained from the system. */
+    int getNumBlocks() const { return freeLists->numBlocks; }
+
+    /** Returns the number of allocations served from a free list. */
+    int getNumReused() const { return freeLists->numReused; }
+
+   protected:
+    /**
+     * The free lists of all the size classes. They are shared with the
+     * outstanding storage, so that it can be returned after the pool is gone.
+     */
+    struct FreeLists {
+        FreeLists() : numBlocks(0), numReused(0) {}
+        ~FreeLists();
+        void release(int sizeClass, void* ptr);
+
+        std::vector<std::vector<void*>> blocks;
+        int numBlocks;
+        int numReused;
+        std::mutex mutex;
+    };
+
+    std::shared_ptr<FreeLists> freeLists;
+};
+
+}  // namespace smaug
+
+#endif
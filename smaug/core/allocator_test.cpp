@@ -0,0 +1,75 @@
+#include <cstdint>
+
+#include "catch.hpp"
+#include "smaug/core/allocator.h"
+#include "smaug/core/globals.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/core/workspace.h"
+#include "smaug/operators/common.h"
+
+using namespace smaug;
+
+TEST_CASE_METHOD(SmaugTest, "Arena allocator", "[allocator]") {
+    ArenaAllocator arena(1024);
+    std::shared_ptr<void> a = arena.allocate(100);
+    std::shared_ptr<void> b = arena.allocate(200);
+    REQUIRE(arena.getNumBlocks() == 1);
+    // Allocations are carved out of the block one after another, at cacheline
+    // granularity.
+    char* aPtr = reinterpret_cast<char*>(a.get());
+    char* bPtr = reinterpret_cast<char*>(b.get());
+    REQUIRE(bPtr - aPtr >= 100);
+    REQUIRE(reinterpret_cast<uintptr_t>(bPtr) % CACHELINE_SIZE == 0);
+
+    SECTION("Full blocks are followed by new ones") {
+        std::shared_ptr<void> c = arena.allocate(1000);
+        REQUIRE(arena.getNumBlocks() == 2);
+        std::shared_ptr<void> d = arena.allocate(5000);
+        REQUIRE(arena.getNumBlocks() == 3);
+    }
+
+    SECTION("Storage outlives the arena") {
+        {
+            ArenaAllocator shortLived(1024);
+            a = shortLived.allocate(16);
+        }
+        *reinterpret_cast<int*>(a.get()) = 42;
+        REQUIRE(*reinterpret_cast<int*>(a.get()) == 42);
+    }
+}
+
+TEST_CASE_METHOD(SmaugTest, "Size class pool", "[allocator]") {
+    SizeClassPool pool;
+    void* first = pool.allocate(1000).get();
+    // The storage was released right away, so the next allocation of the same
+    // size class reuses it.
+    std::shared_ptr<void> second = pool.allocate(1024);
+    REQUIRE(second.get() == first);
+    REQUIRE(pool.getNumBlocks() == 1);
+    REQUIRE(pool.getNumReused() == 1);
+    std::shared_ptr<void> third = pool.allocate(1000);
+    REQUIRE(third.get() != first);
+    std::shared_ptr<void> other = pool.allocate(3000);
+    REQUIRE(pool.getNumBlocks() == 3);
+}
+
+TEST_CASE_METHOD(SmaugTest, "Workspace allocators", "[allocator]") {
+    Workspace ws;
+    Tensor* weights = ws.addTensor(new Tensor(
+            "weights", TensorShape({ 8, 8 }, DataLayout::NC)));
+    weights->allocateStorage<float>();
+    REQUIRE(weights->getAllocator() == ws.getArena());
+    REQUIRE(weights->getStorage().get() != nullptr);
+
+    SECTION("Allocators can be disabled") {
+        useArenaAllocators = false;
+        Workspace heapWs;
+        Tensor* tensor = heapWs.addTensor(new Tensor(
+                "tensor", TensorShape({ 8, 8 }, DataLayout::NC)));
+        REQUIRE(tensor->getAllocator() == nullptr);
+        tensor->allocateStorage<float>();
+        REQUIRE(tensor->getStorage().get() != nullptr);
+        useArenaAllocators = true;
+    }
+}
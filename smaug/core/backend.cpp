@@ -33,6 +33,7 @@
 #include "smaug/operators/smv/smv_eltwise_mul_op.h"
 #include "smaug/operators/smv/smv_less_op.h"
 #include "smaug/operators/smv/smv_greater_op.h"
+#include "smaug/operators/smv/kernels/params.h"
 
 namespace smaug {
 
@@ -119,6 +120,10 @@ const unsigned kPoolingHw = 0x0005;
 
 namespace smv {
 int kSpadSize;
+int kSpadSizes[3] = { 32 * 1024, 32 * 1024, 32 * 1024 };
+// The PE and MACC counts default to the datapath the kernels are built with.
+int kNumPEs = NUM_PE_INSTS;
+int kNumMaccsPerPE = NUM_MACC_INSTS * VECTOR_SIZE;
 // Use the same accelerator id for all hardware blocks. This means we will
 // simulate only ONE datapath instead of multiple, which means that the two
 // blocks can share the scratchpads (without any infrastructure
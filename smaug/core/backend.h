@@ -1,6 +1,7 @@
 #ifndef _CORE_BACKEND_H_
 #define _CORE_BACKEND_H_
 
+#include <algorithm>
 #include <string>
 
 #include "smaug/core/datatypes.h"
@@ -132,7 +133,20 @@ class ReferenceBackend {
  * The smv namespace contains all code specific to the Smv backend.
  */
 namespace smv {
+/**
+ * The size of the smallest scratchpad, in bytes of float16 data. Tiles that
+ * could be placed in any of the scratchpads must fit in this.
+ */
 extern int kSpadSize;
+/**
+ * The sizes of the three scratchpads of each accelerator (spad0, spad1 and
+ * spad2), in bytes of float16 data. These can be set before initGlobals().
+ */
+extern int kSpadSizes[3];
+/** The number of PEs of the convolution and inner product engines. */
+extern int kNumPEs;
+/** The number of MACCs in each PE, in float16 elements. */
+extern int kNumMaccsPerPE;
 extern const unsigned kConvolutionHw;
 extern const unsigned kInnerProductHw;
 extern const unsigned kEltwiseOpHw;
@@ -193,16 +207,19 @@ class SmvBackend {
     static const DataLayout DefaultInputDataLayout = DataLayout::NHWC;
 
     static int SpadSize() { return smv::kSpadSize; }
+    /** Returns the size of the scratchpad spad<index>. */
+    static int SpadSize(int index) { return smv::kSpadSizes[index]; }
     static void initGlobals() {
         // kSpadSize is in terms of float16 data.
-        smv::kSpadSize = 32 * 1024;
+        smv::kSpadSize = *std::min_element(
+                smv::kSpadSizes, smv::kSpadSizes + 3);
         // In SMV, all tensors store float16 data, but due to the modelling
         // restriction of Aladdin, we actually store float32 data in the
         // scratchpads. This why the allocated memory size here is double
         // kSpadSize.
-        smv::spad0 = (float*)malloc_aligned(smv::kSpadSize * 2);
-        smv::spad1 = (float*)malloc_aligned(smv::kSpadSize * 2);
-        smv::spad2 = (float*)malloc_aligned(smv::kSpadSize * 2);
+        smv::spad0 = (float*)malloc_aligned(smv::kSpadSizes[0] * 2);
+        smv::spad1 = (float*)malloc_aligned(smv::kSpadSizes[1] * 2);
+        smv::spad2 = (float*)malloc_aligned(smv::kSpadSizes[2] * 2);
     }
     static void freeGlobals() {
         free(smv::spad0);
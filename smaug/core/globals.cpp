@@ -6,4 +6,11 @@ bool fastForwardMode = true;
 int numAcceleratorsAvailable;
 ThreadPool* threadPool = nullptr;
 bool useSystolicArrayWhenAvailable;
+bool pipelineTiles = false;
+bool planTensorMemory = true;
+bool allocateTensorsOnDemand = false;
+bool useTileViews = true;
+bool useArenaAllocators = true;
+bool lazyLoadParams = false;
+bool useTilingCostModel = false;
 }  // namespace smaug
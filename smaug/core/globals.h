@@ -40,6 +40,56 @@ extern ThreadPool* threadPool;
  */
 extern bool useSystolicArrayWhenAvailable;
 
+/**
+ * If true, operators that support it overlap the copying of data in and out
+ * of tiles with kernel execution, using the thread pool.
+ */
+extern bool pipelineTiles;
+
+/**
+ * If true, the network builder plans the storage of the operator outputs with
+ * a MemoryPlanner, so that tensors with disjoint lifetimes share host memory.
+ */
+extern bool planTensorMemory;
+
+/**
+ * If true, the Scheduler allocates the storage of an operator's outputs right
+ * before running it and frees it once all of their consumers have run. Tensors
+ * on untaken control flow paths are never allocated. This takes precedence
+ * over planTensorMemory.
+ */
+extern bool allocateTensorsOnDemand;
+
+/**
+ * If true, tiles that occupy one contiguous range of the tiled Tensor are
+ * views into its storage, instead of copies (see TiledTensor::setTileView()).
+ */
+extern bool useTileViews;
+
+/**
+ * If true, each Workspace allocates the storage of long-lived Tensors from an
+ * arena, and the storage of tiles and on-demand outputs from a size-class pool
+ * (see Workspace::getArena() and Workspace::getPool()), instead of making a
+ * separate heap allocation for every Tensor.
+ */
+extern bool useArenaAllocators;
+
+/**
+ * If true, the Scheduler reads the weights in a memory mapped parameters file
+ * (see ParamFile) into memory right before their consumers run. In single-shot
+ * runs (see Scheduler::setSingleShot()), it also drops them from memory again
+ * once all their consumers have run, so that the weights of a model need not
+ * fit in memory all at once.
+ */
+extern bool lazyLoadParams;
+
+/**
+ * If true, the SMV tiling optimizers pick the tiling plan with the lowest
+ * estimated data movement and kernel invocation cost (see smv::TilingCost),
+ * instead of the one that fills the scratchpads the most.
+ */
+extern bool useTilingCostModel;
+
 }  // namespace smaug
 
 #endif
@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <list>
+#include <set>
+
+#include "smaug/core/memory_planner.h"
+#include "smaug/operators/common.h"
+#include "smaug/utility/debug_stream.h"
+#include "smaug/utility/utils.h"
+
+namespace smaug {
+
+void MemoryPlanner::plan() {
+    const Graph& graph = network->getGraph();
+    EdgeNameMap edges = get(boost::edge_name, graph);
+    std::list<Vertex> vertices;
+    boost::topological_sort(graph, std::front_inserter(vertices));
+    std::vector<int> topoIndex(boost::num_vertices(graph));
+    int index = 0;
+    for (auto v : vertices)
+        topoIndex[v] = index++;
+
+    // Collect the transitive predecessors of every operator.
+    ancestors.assign(vertices.size(),
+                     boost::dynamic_bitset<>(vertices.size()));
+    for (auto v : vertices) {
+        boost::dynamic_bitset<>& vertexAncestors = ancestors[topoIndex[v]];
+        in_edge_iter inEdgeIt, inEdgeEnd;
+        for (boost::tie(inEdgeIt, inEdgeEnd) = in_edges(v, graph);
+             inEdgeIt != inEdgeEnd;
+             ++inEdgeIt) {
+            int parent = topoIndex[source(*inEdgeIt, graph)];
+            vertexAncestors |= ancestors[parent];
+            vertexAncestors.set(parent);
+        }
+    }
+
+    // Find the output tensors that need storage and their consumers.
+    buffers.clear();
+    std::set<Tensor*> seen;
+    for (auto v : vertices) {
+        Operator* op = get(boost::vertex_op, graph, v);
+        for (int i = 0; i < op->getOutputs().size(); i++) {
+            Tensor* tensor = op->getOutput(i);
+            if (!tensor || tensor->containsData() ||
+                tensor->getDataType() == UnknownDataType ||
+                !seen.insert(tensor).second)
+                continue;
+            Buffer buffer;
+            buffer.tensor = tensor;
+            buffer.producer = topoIndex[v];
+            buffer.size = next_multiple(tensor->getShape().storageSize() *
+                                                tensor->getDataTypeSize(),
+                                        CACHELINE_SIZE);
+            buffer.offset = 0;
+            out_edge_iter outEdgeIt, outEdgeEnd;
+            for (boost::tie(outEdgeIt, outEdgeEnd) = out_edges(v, graph);
+                 outEdgeIt != outEdgeEnd;
+                 ++outEdgeIt) {
+                if (edges[*outEdgeIt].srcIdx == i) {
+                    buffer.consumers.push_back(
+                            topoIndex[target(*outEdgeIt, graph)]);
+                }
+            }
+            buffers.push_back(buffer);
+        }
+    }
+
+    // Place the largest tensors first, each at the lowest offset that does not
+    // overlap any already placed tensor that may be live at the same time.
+    std::vector<Buffer*> order;
+    for (auto& buffer : buffers)
+        order.push_back(&buffer);
+    std::stable_sort(order.begin(), order.end(), [](Buffer* a, Buffer* b) {
+        return a->size > b->size;
+    });
+    arenaSize = 0;
+    std::vector<Buffer*> placed;
+    for (Buffer* buffer : order) {
+        std::vector<Buffer*> conflicts;
+        for (Buffer* other : placed) {
+            if (!isDeadBefore(*buffer, *other) &&
+                !isDeadBefore(*other, *buffer))
+                conflicts.push_back(other);
+        }
+        std::sort(conflicts.begin(), conflicts.end(), [](Buffer* a, Buffer* b) {
+            return a->offset < b->offset;
+        });
+        size_t offset = 0;
+        for (Buffer* other : conflicts) {
+            if (offset + buffer->size <= other->offset)
+                break;
+            offset = std::max(offset, other->offset + other->size);
+        }
+        buffer->offset = offset;
+        arenaSize = std::max(arenaSize, offset + buffer->size);
+        placed.push_back(buffer);
+        dout(1) << "Planned " << buffer->tensor->getName() << " at offset "
+                << offset << " (" << buffer->size << " bytes).\n";
+    }
+}
+
+void MemoryPlanner::allocate() {
+    if (arenaSize == 0)
+        return;
+    std::shared_ptr<void> arena(malloc_aligned(arenaSize, false), free);
+    for (auto& buffer : buffers) {
+        // The aliasing constructor shares the ownership of the arena.
+        buffer.tensor->setStorage(std::shared_ptr<void>(
+                arena, reinterpret_cast<char*>(arena.get()) + buffer.offset));
+    }
+}
+
+size_t MemoryPlanner::getTotalTensorSize() const {
+    size_t totalSize = 0;
+    for (auto& buffer : buffers)
+        totalSize += buffer.size;
+    return totalSize;
+}
+
+int64_t MemoryPlanner::getOffset(const Tensor* tensor) const {
+    for (auto& buffer : buffers) {
+        if (buffer.tensor == tensor)
+            return buffer.offset;
+    }
+    return -1;
+}
+
+bool MemoryPlanner::isDeadBefore(const Buffer& a, const Buffer& b) const {
+    // A tensor that nobody reads is an output of the network.
+    if (a.consumers.empty())
+        return false;
+    for (int consumer : a.consumers) {
+        if (!ancestors[b.producer][consumer])
+            return false;
+    }
+    return true;
+}
+
+}  // namespace smaug
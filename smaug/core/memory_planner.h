@@ -0,0 +1,90 @@
+#ifndef _CORE_MEMORY_PLANNER_H_
+#define _CORE_MEMORY_PLANNER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <boost/dynamic_bitset.hpp>
+
+#include "smaug/core/network.h"
+#include "smaug/core/tensor.h"
+
+namespace smaug {
+
+/**
+ * MemoryPlanner statically assigns the output tensors of a Network to offsets
+ * in a single host memory arena, so that tensors with disjoint lifetimes share
+ * the same memory.
+ *
+ * A tensor is live from the time its producer runs until all of its consumers
+ * have run. Since the Scheduler may run operators in any order consistent with
+ * the dataflow graph (see ConcurrentScheduler), a tensor is only considered
+ * dead before another one is produced if every consumer of the former is an
+ * ancestor of the producer of the latter. Tensors without consumers, like the
+ * network output, stay live until the end.
+ *
+ * Only operator outputs that have a data type but no storage yet are planned.
+ * Tensors that already hold data, like weights and inputs, are left alone.
+ */
+class MemoryPlanner {
+   public:
+    MemoryPlanner(Network* _network) : network(_network), arenaSize(0) {}
+
+    /** Computes the tensor lifetimes and assigns arena offsets to them. */
+    void plan();
+
+    /**
+     * Allocates the arena and points every planned tensor at its offset in
+     * it. The arena is freed once all of these tensors are destroyed.
+     */
+    void allocate();
+
+    /** Returns the size of the arena in bytes. */
+    size_t getArenaSize() const { return arenaSize; }
+
+    /**
+     * Returns the total size in bytes of the planned tensors, which is what
+     * they would take up without any memory reuse.
+     */
+    size_t getTotalTensorSize() const;
+
+    /**
+     * Returns the offset of the tensor in the arena, or -1 if the tensor was
+     * not planned.
+     */
+    int64_t getOffset(const Tensor* tensor) const;
+
+   protected:
+    /** A planned tensor. */
+    struct Buffer {
+        Tensor* tensor;
+        /** Topological index of the operator that produces the tensor. */
+        int producer;
+        /** Topological indices of the operators that read the tensor. */
+        std::vector<int> consumers;
+        /** Size in bytes, rounded up to a cacheline. */
+        size_t size;
+        /** Offset in bytes into the arena. */
+        size_t offset;
+    };
+
+    /**
+     * Returns true if buffer a is dead by the time buffer b is produced in
+     * every possible schedule.
+     */
+    bool isDeadBefore(const Buffer& a, const Buffer& b) const;
+
+    Network* network;
+    std::vector<Buffer> buffers;
+    /**
+     * The transitive predecessors of each operator, indexed by topological
+     * index.
+     */
+    std::vector<boost::dynamic_bitset<>> ancestors;
+    size_t arenaSize;
+};
+
+}  // namespace smaug
+
+#endif
@@ -0,0 +1,127 @@
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/memory_planner.h"
+#include "smaug/core/scheduler.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/operators/data_op.h"
+#include "smaug/operators/eltwise_add_op.h"
+#include "smaug/operators/relu_op.h"
+
+using namespace smaug;
+
+class MemoryPlannerTest : public SmaugTest {
+   public:
+    DataOp<ReferenceBackend>* addInput() {
+        TensorShape shape({ 1, kNumElems }, DataLayout::NC);
+        Tensor* input = new Tensor("input", shape);
+        input->allocateStorage<float>();
+        std::vector<float> data(kNumElems);
+        for (int i = 0; i < kNumElems; i++)
+            data[i] = i % 2 == 0 ? i : -i;
+        input->fillData(data.data(), data.size());
+        workspace()->addTensor(input);
+        auto dataOp = new DataOp<ReferenceBackend>("data", workspace());
+        dataOp->setData(input);
+        network()->addOperator(dataOp);
+        return dataOp;
+    }
+
+    ReluOp<ReferenceBackend>* addRelu(const std::string& name, Operator* src) {
+        auto reluOp = new ReluOp<ReferenceBackend>(name, workspace());
+        connect(src, reluOp, 0);
+        return reluOp;
+    }
+
+    // The output of relu(input), or of relu(input) + relu(input).
+    std::vector<float> expectedOutput(int scale) const {
+        std::vector<float> expected(kNumElems);
+        for (int i = 0; i < kNumElems; i++)
+            expected[i] = i % 2 == 0 ? scale * i : 0;
+        return expected;
+    }
+
+    int64_t offset(const MemoryPlanner& planner, Operator* op) const {
+        return planner.getOffset(op->getOutput(0));
+    }
+
+   protected:
+    // Connects the output of src to the input of dest at destIdx. Once all of
+    // dest's inputs are connected, its output tensors are created without any
+    // storage.
+    void connect(Operator* src, Operator* dest, int destIdx) {
+        if (destIdx == 0)
+            network()->addOperator(dest);
+        dest->setInput(src->getOutput(0), destIdx);
+        network()->addEdge(src, dest, { 0, destIdx });
+        if (destIdx == dest->getInputs().size() - 1) {
+            dest->createAllTensors();
+            dest->getOutput(0)->setDataType(Float32);
+        }
+    }
+
+    static constexpr int kNumElems = 32;
+    static constexpr int kTensorSize = kNumElems * sizeof(float);
+};
+
+TEST_CASE_METHOD(MemoryPlannerTest, "Plan tensor memory", "[planner]") {
+    auto dataOp = addInput();
+
+    SECTION("Chain of operators") {
+        auto relu0 = addRelu("relu0", dataOp);
+        auto relu1 = addRelu("relu1", relu0);
+        auto relu2 = addRelu("relu2", relu1);
+        auto relu3 = addRelu("relu3", relu2);
+        MemoryPlanner planner(network());
+        planner.plan();
+        // Only the input and output of each operator are live at once.
+        REQUIRE(planner.getTotalTensorSize() == 4 * kTensorSize);
+        REQUIRE(planner.getArenaSize() == 2 * kTensorSize);
+        REQUIRE(planner.getOffset(dataOp->getOutput(0)) == -1);
+        REQUIRE(offset(planner, relu0) == offset(planner, relu2));
+        REQUIRE(offset(planner, relu1) == offset(planner, relu3));
+        REQUIRE(offset(planner, relu0) != offset(planner, relu1));
+
+        planner.allocate();
+        Scheduler scheduler(network(), workspace());
+        Tensor* output = scheduler.runNetwork();
+        REQUIRE(output == relu3->getOutput(0));
+        verifyOutputs(output, expectedOutput(1));
+    }
+
+    SECTION("Concurrent branches") {
+        auto relu0 = addRelu("relu0", dataOp);
+        auto relu1 = addRelu("relu1", dataOp);
+        auto addOp = new EltwiseAddOp<ReferenceBackend>("add", workspace());
+        connect(relu0, addOp, 0);
+        connect(relu1, addOp, 1);
+        auto relu2 = addRelu("relu2", addOp);
+        MemoryPlanner planner(network());
+        planner.plan();
+        // The two branches may run at the same time, and the addition reads
+        // both of them while it writes its output.
+        REQUIRE(planner.getArenaSize() == 3 * kTensorSize);
+        REQUIRE(offset(planner, relu0) != offset(planner, relu1));
+        REQUIRE(offset(planner, addOp) != offset(planner, relu0));
+        REQUIRE(offset(planner, addOp) != offset(planner, relu1));
+        REQUIRE(offset(planner, relu2) != offset(planner, addOp));
+
+        planner.allocate();
+        ConcurrentScheduler scheduler(network(), workspace(), 2);
+        Tensor* output = scheduler.runNetwork();
+        REQUIRE(output == relu2->getOutput(0));
+        verifyOutputs(output, expectedOutput(2));
+    }
+
+    SECTION("Outputs without consumers are never reused") {
+        auto relu0 = addRelu("relu0", dataOp);
+        auto side = addRelu("side", relu0);
+        auto relu1 = addRelu("relu1", relu0);
+        auto relu2 = addRelu("relu2", relu1);
+        auto relu3 = addRelu("relu3", relu2);
+        MemoryPlanner planner(network());
+        planner.plan();
+        for (auto op : { relu0, relu1, relu2, relu3 })
+            REQUIRE(offset(planner, side) != offset(planner, op));
+    }
+}
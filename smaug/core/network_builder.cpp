@@ -1,14 +1,21 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <iostream>
 #include <fstream>
-#include <fcntl.h>
+#include <thread>
+#include <unordered_map>
 
 #include <google/protobuf/text_format.h>
 #include <google/protobuf/io/zero_copy_stream_impl.h>
 
 #include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
+#include "smaug/core/memory_planner.h"
 #include "smaug/core/tensor.h"
 #include "smaug/core/network.h"
 #include "smaug/core/network_builder.h"
+#include "smaug/core/param_file.h"
 #include "smaug/core/workspace.h"
 #include "smaug/core/graph.pb.h"
 #include "smaug/core/node.pb.h"
@@ -94,11 +101,56 @@ ActivationInfo getActivationInfo(const ActivationParams& params) {
     return actInfo;
 }
 
+// The tensor data in the parameters file, indexed by tensor name.
+typedef std::unordered_map<std::string, const TensorData*> TensorDataMap;
+
+// A parameter tensor whose storage is allocated, but whose data is yet to be
+// decoded.
+struct PendingTensorData {
+    Tensor* tensor;
+    const TensorData* tensorData;
+};
+
+// Decode the data of all the pending parameter tensors. Their storage has
+// already been allocated, so the tensors are independent of each other and
+// are decoded in parallel when there is a thread pool. This runs before the
+// thread pool is initialized, so it uses its own threads, as many as the pool
+// has. The largest tensors go first to balance the work between the threads.
+static void decodeTensorData(std::vector<PendingTensorData>& pendingData) {
+    int numThreads = 1;
+    if (threadPool && !runningInSimulation)
+        numThreads = std::min<int>(threadPool->size(), pendingData.size());
+    if (numThreads <= 1) {
+        for (auto& pending : pendingData)
+            pending.tensor->fillData(*pending.tensorData);
+        return;
+    }
+    std::stable_sort(pendingData.begin(), pendingData.end(),
+                     [](const PendingTensorData& a,
+                        const PendingTensorData& b) {
+                         return a.tensor->getShape().storageSize() >
+                                b.tensor->getShape().storageSize();
+                     });
+    std::atomic<int> next(0);
+    auto decode = [&pendingData, &next]() {
+        for (int i = next++; i < pendingData.size(); i = next++)
+            pendingData[i].tensor->fillData(*pendingData[i].tensorData);
+    };
+    std::vector<std::thread> workers;
+    for (int i = 0; i < numThreads; i++)
+        workers.emplace_back(decode);
+    for (auto& worker : workers)
+        worker.join();
+}
+
 // Create an operator by deserializing a node in the graph, and add it to the
-// network.
+// network. The data of parameter tensors is not decoded here, but added to
+// pendingData.
 template <typename Backend>
 static void createAndAddOperator(const NodeProto& node,
-                                 const TensorDataArray& tensorDataArray,
+                                 const TensorDataMap& tensorDataMap,
+                                 std::vector<PendingTensorData>& pendingData,
+                                 const ParamFile* paramFile,
                                  HostMemoryAccessPolicy memPolicy,
                                  Network* network,
                                  Workspace* workspace) {
@@ -108,17 +160,24 @@ static void createAndAddOperator(const NodeProto& node,
     dout(0) << "Adding " << name << " (" << OpType_Name(type) << ").\n";
 
     if (type == OpType::Data) {
-        // Find the tensor data from the tensor data array.
-        TensorData tensorData;
-        for (int i = 0; i < tensorDataArray.data_array_size(); i++) {
-            if (tensorDataArray.data_array(i).name() ==
-                node.input_tensors(0).name()) {
-                tensorData = tensorDataArray.data_array(i);
-                break;
-            }
+        const TensorProto& tensorProto = node.input_tensors(0);
+        Tensor* tensor;
+        if (paramFile && paramFile->contains(tensorProto.name())) {
+            // Use the mapped tensor data directly.
+            tensor = new Tensor(tensorProto.name(),
+                                TensorShape(tensorProto.shape()));
+            tensor->setDataType(tensorProto.data_type());
+            tensor->setStorage(paramFile->getTensorData(*tensor));
+        } else {
+            // Allocate the storage now, in the order of the nodes, and leave
+            // decoding the data for later.
+            tensor = new Tensor(tensorProto, workspace->getArena());
+            tensor->allocateStorage(tensorProto.data_type());
+            auto it = tensorDataMap.find(tensorProto.name());
+            if (it != tensorDataMap.end())
+                pendingData.push_back({ tensor, it->second });
         }
-        auto inputTensor = workspace->addTensor(
-                new Tensor(node.input_tensors(0), tensorData));
+        auto inputTensor = workspace->addTensor(tensor);
         auto inputTensorOp = Backend::createDataOp(name, workspace);
         inputTensorOp->setData(inputTensor);
         network->addOperator(inputTensorOp);
@@ -295,17 +354,18 @@ static void createAndAddOperator(const NodeProto& node,
         assert(false && "Invalid host memory access policy!");
     }
 
-    // Create the output tensors and allocate storage for them.
-    // TODO: The tensor storage allocation can be deferred until scheduling
-    // time, which can benefit future control flow operators because the untaken
-    // branch of the control flow will not have that memory allocated and
-    // filled.
+    // Create the output tensors. Their storage is either assigned by the
+    // memory planner once the whole network is built, allocated by the
+    // scheduler when the operator runs, or otherwise allocated right here.
     for (int i = 0; i < op->getOutputs().size(); i++) {
         if (!op->getOutput(i)) {
             const TensorProto& tensorProto = node.output_tensors(i);
             Tensor* output = workspace->addTensor(
                     new Tensor(tensorProto.name(), tensorProto.shape()));
-            output->allocateStorage(tensorProto.data_type());
+            if (planTensorMemory || allocateTensorsOnDemand)
+                output->setDataType(tensorProto.data_type());
+            else
+                output->allocateStorage(tensorProto.data_type());
             op->setOutput(output, i);
         }
     }
@@ -316,19 +376,31 @@ static void createAndAddOperator(const NodeProto& node,
 template <typename Backend>
 static Network* createNetworkFromProto(const GraphProto& graphProto,
                                        const TensorDataArray& tensorDataArray,
+                                       const ParamFile* paramFile,
                                        SamplingInfo& sampling,
                                        Workspace* workspace) {
     Network* network = new Network(graphProto.name());
     network->setSamplingInfo(sampling);
+    TensorDataMap tensorDataMap;
+    tensorDataMap.reserve(tensorDataArray.data_array_size());
+    for (int i = 0; i < tensorDataArray.data_array_size(); i++) {
+        const TensorData& tensorData = tensorDataArray.data_array(i);
+        tensorDataMap.emplace(tensorData.name(), &tensorData);
+    }
+    std::vector<PendingTensorData> pendingData;
     for (int i = 0; i < graphProto.nodes_size(); i++) {
         const NodeProto& node = graphProto.nodes(i);
         createAndAddOperator<Backend>(node,
-                                      tensorDataArray,
+                                      tensorDataMap,
+                                      pendingData,
+                                      paramFile,
                                       graphProto.mem_policy(),
                                       network,
                                       workspace);
     }
 
+    decodeTensorData(pendingData);
+
     // Now every operator has been added into the network, we can connect them
     // together by adding edges in the graph view of the network.
     for (int i = 0; i < graphProto.nodes_size(); i++) {
@@ -363,34 +435,89 @@ static Network* createNetworkFromProto(const GraphProto& graphProto,
         }
     }
 
+    if (planTensorMemory && !allocateTensorsOnDemand) {
+        MemoryPlanner planner(network);
+        planner.plan();
+        planner.allocate();
+        cout << "Planned tensor memory: " << planner.getArenaSize()
+             << " bytes (" << planner.getTotalTensorSize()
+             << " bytes without reuse).\n";
+    }
+
     return network;
 }
 
+// Returns the size of the binary topology header, or 0 if the file doesn't
+// start with one.
+static size_t readBinaryTopologyHeader(std::istream& file) {
+    char magic[sizeof(binary_topo::kMagic) - 1];
+    uint32_t version;
+    if (!file.read(magic, sizeof(magic)) ||
+        memcmp(magic, binary_topo::kMagic, sizeof(magic)) != 0 ||
+        !file.read(reinterpret_cast<char*>(&version), sizeof(version)) ||
+        version != binary_topo::kVersion) {
+        return 0;
+    }
+    return sizeof(magic) + sizeof(version);
+}
+
+// Parse the network topology from either a binary topology file or a
+// protobuf text file.
+static bool parseTopology(const std::string& modelTopo, GraphProto& graph) {
+    fstream modelTopoFile(modelTopo, ios::in | ios::binary);
+    if (!modelTopoFile) {
+        cout << modelTopo << ": network topology file not found." << endl;
+        exit(1);
+    }
+    if (readBinaryTopologyHeader(modelTopoFile) > 0)
+        return graph.ParseFromIstream(&modelTopoFile);
+    modelTopoFile.clear();
+    modelTopoFile.seekg(0);
+    google::protobuf::io::IstreamInputStream modelTopoInput(&modelTopoFile);
+    return google::protobuf::TextFormat::Parse(&modelTopoInput, &graph);
+}
+
+bool smaug::writeBinaryTopology(const GraphProto& graph,
+                                const std::string& path) {
+    fstream file(path, ios::out | ios::binary | ios::trunc);
+    uint32_t version = binary_topo::kVersion;
+    file.write(binary_topo::kMagic, sizeof(binary_topo::kMagic) - 1);
+    file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    return file && graph.SerializeToOstream(&file);
+}
+
 Network* smaug::buildNetwork(const std::string& modelTopo,
                              const std::string& modelParams,
                              SamplingInfo& sampling,
                              Workspace* workspace) {
-    // Parse the network topology from the protobuf text file.
+    // Parse the network topology, which is either in the binary format or a
+    // protobuf text file.
     GraphProto graph;
-    int modelTopoDescriptor = open(modelTopo.c_str(), O_RDONLY);
-    if (modelTopoDescriptor < 0) {
-        cout << modelTopo << ": network topology file not found." << endl;
-        exit(1);
-    }
-    google::protobuf::io::FileInputStream modelTopoInput(modelTopoDescriptor);
-    if (!google::protobuf::TextFormat::Parse(&modelTopoInput, &graph)) {
+    if (!parseTopology(modelTopo, graph)) {
         cout << "Failed to parse the network topology file!" << endl;
         exit(1);
     }
-    // Parse the network parameters from the protobuf binary file.
+    // The network parameters are either in the raw format, which is memory
+    // mapped, or in a protobuf binary file, which is parsed.
     TensorDataArray tensorDataArray;
-    fstream modelParamsFile(modelParams, ios::in | ios::binary);
-    if (!modelParamsFile) {
-        cout << modelParams << ": network parameters file not found." << endl;
-        exit(1);
-    } else if (!tensorDataArray.ParseFromIstream(&modelParamsFile)) {
-        cout << "Failed to parse the network parameters file.\n";
-        exit(1);
+    std::shared_ptr<ParamFile> paramFile;
+    if (ParamFile::isParamFile(modelParams)) {
+        paramFile = std::make_shared<ParamFile>();
+        if (!paramFile->load(modelParams)) {
+            cout << "Failed to load the network parameters file.\n";
+            exit(1);
+        }
+        workspace->setParamFile(paramFile);
+    } else {
+        fstream modelParamsFile(modelParams, ios::in | ios::binary);
+        if (!modelParamsFile) {
+            cout << modelParams << ": network parameters file not found."
+                 << endl;
+            exit(1);
+        } else if (!tensorDataArray.ParseFromIstream(&modelParamsFile)) {
+            cout << "Failed to parse the network parameters file.\n";
+            exit(1);
+        }
     }
 
     cout << "======================================================\n";
@@ -399,10 +526,12 @@ Network* smaug::buildNetwork(const std::string& modelTopo,
     Network* network = nullptr;
     if (graph.backend() == ReferenceBackend::Name) {
         network = createNetworkFromProto<ReferenceBackend>(
-                graph, tensorDataArray, sampling, workspace);
+                graph, tensorDataArray, paramFile.get(),
+                sampling, workspace);
     } else if (graph.backend() == SmvBackend::Name) {
         network = createNetworkFromProto<SmvBackend>(
-                graph, tensorDataArray, sampling, workspace);
+                graph, tensorDataArray, paramFile.get(),
+                sampling, workspace);
     } else {
         assert(false && "Unknown backend!");
     }
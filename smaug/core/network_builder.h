@@ -5,18 +5,46 @@
 
 #include "smaug/core/workspace.h"
 #include "smaug/core/network.h"
+#include "smaug/core/graph.pb.h"
 #include "smaug/operators/common.h"
 
 namespace smaug {
 
+/**
+ * A model topology in the binary format, as an alternative to a text
+ * protobuf. The file is a short header followed by the GraphProto in the
+ * protobuf binary encoding:
+ *
+ *   char[8]  magic ("SMAUGTOP")
+ *   uint32   version (little endian)
+ *   bytes    serialized GraphProto
+ *
+ * Parsing text protobufs dominates the loading time of graphs with thousands
+ * of nodes, like unrolled recurrent models, while binary ones are decoded
+ * directly. Text topologies remain supported for debugging.
+ */
+namespace binary_topo {
+constexpr char kMagic[] = "SMAUGTOP";
+constexpr uint32_t kVersion = 1;
+}  // namespace binary_topo
+
+/**
+ * Writes the topology to a file in the binary format. Returns false if the
+ * file can't be written.
+ */
+bool writeBinaryTopology(const GraphProto& graph, const std::string& path);
+
 /**
  * buildNetwork reads the specified model topology and parameters protobufs and
  * simulation sampling directives and returns a populated Network that can be
  * run.
  *
- * @param modelTopoFile The path to the model topology protobuf.
- * @param modelParamsFile The path to the model parameters protobuf, which
- * contains values for all tensors in the network (weights *and* inputs).
+ * @param modelTopoFile The path to the model topology, which is either a text
+ * protobuf or a binary topology file (see writeBinaryTopology()).
+ * @param modelParamsFile The path to the model parameters, which contains
+ * values for all tensors in the network (weights *and* inputs). This is either
+ * a protobuf or a raw parameters file (see ParamFile), which is memory mapped
+ * instead of parsed.
  * @param sampling Level of simulation sampling to apply to applicable kernels.
  * @param workspace Pointer to the global Workspace holding all tensors and
  * operators.
@@ -0,0 +1,143 @@
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+#include <google/protobuf/text_format.h>
+
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
+#include "smaug/core/graph.pb.h"
+#include "smaug/core/network_builder.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.pb.h"
+#include "smaug/utility/thread_pool.h"
+
+using namespace smaug;
+
+// Returns the value of element i of the n-th parameter tensor.
+static int getParamValue(int n, int i) { return n * 1000 + i; }
+
+// Writes a model of numParams Data nodes, each with a parameter tensor of a
+// different size. The tensor data is stored in the reverse order of the nodes.
+static void writeModel(const std::string& topoPath,
+                       const std::string& paramsPath,
+                       int numParams,
+                       bool binaryTopo = false) {
+    GraphProto graph;
+    graph.set_name("params");
+    graph.set_backend(ReferenceBackend::Name);
+    graph.set_mem_policy(HostMemoryAccessPolicy::AllDma);
+    TensorDataArray tensorDataArray;
+    for (int n = numParams - 1; n >= 0; n--) {
+        std::string name = "param" + std::to_string(n);
+        int size = (n + 1) * 64;
+        DataType dataType = n % 2 == 0 ? Float32 : Int32;
+        NodeProto* node = graph.add_nodes();
+        node->set_name(name);
+        node->set_op(OpType::Data);
+        TensorProto* tensorProto = node->add_input_tensors();
+        tensorProto->set_name(name);
+        tensorProto->set_data_type(dataType);
+        tensorProto->mutable_shape()->add_dims(1);
+        tensorProto->mutable_shape()->add_dims(size);
+        tensorProto->mutable_shape()->set_layout(DataLayout::NC);
+        *node->add_output_tensors() = *tensorProto;
+
+        TensorData* tensorData = tensorDataArray.add_data_array();
+        tensorData->set_name(name);
+        for (int i = 0; i < size; i++) {
+            if (dataType == Float32)
+                tensorData->add_float_data(getParamValue(n, i));
+            else
+                tensorData->add_int_data(getParamValue(n, i));
+        }
+    }
+    if (binaryTopo) {
+        writeBinaryTopology(graph, topoPath);
+    } else {
+        std::string topo;
+        google::protobuf::TextFormat::PrintToString(graph, &topo);
+        std::ofstream(topoPath) << topo;
+    }
+    std::ofstream paramsFile(paramsPath, std::ios::binary);
+    tensorDataArray.SerializeToOstream(&paramsFile);
+}
+
+// Returns true if all the parameter tensors of the network hold their data.
+template <typename T>
+static bool verifyParam(Network* network, int n) {
+    Tensor* tensor =
+            network->getOperator("param" + std::to_string(n))->getInput(0);
+    const T* data = tensor->data<T>();
+    for (int i = 0; i < tensor->getShape().size(); i++) {
+        if (data[i] != getParamValue(n, i))
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE_METHOD(SmaugTest, "Parameter tensors are decoded", "[builder]") {
+    char topoTemplate[] = "/tmp/smaug_topo_XXXXXX";
+    close(mkstemp(topoTemplate));
+    char paramsTemplate[] = "/tmp/smaug_params_XXXXXX";
+    close(mkstemp(paramsTemplate));
+    std::string topoPath = topoTemplate;
+    std::string paramsPath = paramsTemplate;
+    const int numParams = 24;
+    writeModel(topoPath, paramsPath, numParams);
+
+    SECTION("Serially") {}
+
+    SECTION("In parallel") {
+        threadPool = new ThreadPool(4, ThreadPool::Block);
+    }
+
+    Workspace workspace;
+    SamplingInfo sampling = { NoSampling, 1 };
+    Network* network =
+            smaug::buildNetwork(topoPath, paramsPath, sampling, &workspace);
+    REQUIRE(network->getOperators().size() == numParams);
+    for (int n = 0; n < numParams; n++) {
+        if (n % 2 == 0)
+            REQUIRE(verifyParam<float>(network, n));
+        else
+            REQUIRE(verifyParam<int>(network, n));
+    }
+    delete network;
+
+    if (threadPool) {
+        delete threadPool;
+        threadPool = nullptr;
+    }
+    std::remove(topoPath.c_str());
+    std::remove(paramsPath.c_str());
+}
+
+TEST_CASE_METHOD(SmaugTest, "Binary topologies", "[builder]") {
+    char topoTemplate[] = "/tmp/smaug_topo_XXXXXX";
+    close(mkstemp(topoTemplate));
+    char paramsTemplate[] = "/tmp/smaug_params_XXXXXX";
+    close(mkstemp(paramsTemplate));
+    std::string topoPath = topoTemplate;
+    std::string paramsPath = paramsTemplate;
+    const int numParams = 4;
+    writeModel(topoPath, paramsPath, numParams, true);
+
+    std::ifstream topoFile(topoPath, std::ios::binary);
+    char magic[8];
+    topoFile.read(magic, sizeof(magic));
+    REQUIRE(std::string(magic, sizeof(magic)) == "SMAUGTOP");
+
+    Workspace workspace;
+    SamplingInfo sampling = { NoSampling, 1 };
+    Network* network =
+            smaug::buildNetwork(topoPath, paramsPath, sampling, &workspace);
+    REQUIRE(network->getOperators().size() == numParams);
+    REQUIRE(verifyParam<float>(network, 0));
+    REQUIRE(verifyParam<int>(network, 1));
+    delete network;
+
+    std::remove(topoPath.c_str());
+    std::remove(paramsPath.c_str());
+}
@@ -1,6 +1,7 @@
 #ifndef _CORE_OPERATOR_H_
 #define _CORE_OPERATOR_H_
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
@@ -34,6 +35,25 @@ class Operator {
 
     virtual void tile() {};
 
+    /**
+     * Returns the TiledTensor that the given input was tiled into by tile(),
+     * or nullptr if this Operator does not tile that input.
+     */
+    virtual TiledTensor* getTiledInput(int index) { return nullptr; }
+
+    /**
+     * Returns the TiledTensor that the given output was tiled into by tile(),
+     * or nullptr if this Operator does not tile that output.
+     */
+    virtual TiledTensor* getTiledOutput(int index) { return nullptr; }
+
+    /**
+     * Returns the TiledTensor that the constant weights of this Operator were
+     * tiled into by tile(), or nullptr if it has no tiled weights. These may
+     * be packed ahead of time (see packWeights()).
+     */
+    virtual TiledTensor* getTiledWeights() { return nullptr; }
+
     /**
      * Executes the Operator.
      *
@@ -77,6 +97,16 @@ class Operator {
      */
     virtual bool isDead();
 
+    /**
+     * Returns true if this Operator only does work on the host CPU.
+     *
+     * Operators that invoke accelerator kernels share accelerator IDs and
+     * scratchpads with each other, so a concurrent scheduler must not run two
+     * of them at the same time. Host-only operators (like data movement and
+     * control flow) can safely run alongside anything else.
+     */
+    virtual bool isHostOnly() const { return false; }
+
     /**
      * Return a list of Tensors whose values that are parameterizable.
      *
@@ -100,7 +130,11 @@ class Operator {
      * */
     void setNumPendingInputs(int num) { numPendingInputs = num; }
     int getNumPendingInputs() const { return numPendingInputs; }
-    void decrNumPendingInputs() { numPendingInputs--; }
+    /**
+     * Atomically decrements the number of pending inputs and returns the new
+     * value, so that exactly one parent sees this operator become ready.
+     */
+    int decrNumPendingInputs() { return --numPendingInputs; }
     const std::string& getName() const { return name; }
     Vertex getVertex() const { return vertex; }
     void setVertex(Vertex v) { vertex = v; }
@@ -147,7 +181,7 @@ class Operator {
     Workspace* workspace;
     /** The number of tensors that this operator is waiting on before it can be
      * scheduled. */
-    int numPendingInputs;
+    std::atomic<int> numPendingInputs;
     /** The memory interface over which input activations are expected to arrive. */
     MemoryType inputsMemType;
     /** The memory interface over which weights are expected to arrive. */
@@ -0,0 +1,92 @@
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "smaug/core/packed_weights.h"
+#include "smaug/core/param_file.h"
+#include "smaug/core/tensor.h"
+
+namespace smaug {
+
+namespace {
+
+/** A weight tile that holds a copy of its data. */
+struct WeightTile {
+    TiledTensor* tiledTensor;
+    int index;
+    std::string name;
+};
+
+/** Returns the name that the tile is stored under in a packed file. */
+std::string getPackedName(Operator* op, TiledTensor* tiledTensor, int index) {
+    const Tensor* tile = (*tiledTensor)[index];
+    std::stringstream name;
+    name << op->getName() << "/weights:" << index << "[";
+    const std::vector<int>& dims = tile->getShape().dims();
+    for (int i = 0; i < dims.size(); i++)
+        name << (i > 0 ? "," : "") << dims[i];
+    name << "]@[";
+    const std::vector<int>& origin = tiledTensor->getTileOrigin(index);
+    for (int i = 0; i < origin.size(); i++)
+        name << (i > 0 ? "," : "") << origin[i];
+    name << "]";
+    return name.str();
+}
+
+/**
+ * Collects the weight tiles of all the operators. Tiles that are views or the
+ * original Tensor itself need no packing.
+ */
+std::vector<WeightTile> findWeightTiles(Network* network) {
+    std::vector<WeightTile> weightTiles;
+    for (auto nameOp : network->getOperators()) {
+        Operator* op = nameOp.second;
+        TiledTensor* tiledTensor = op->getTiledWeights();
+        if (!tiledTensor)
+            continue;
+        for (int i = 0; i < tiledTensor->size(); i++) {
+            if (tiledTensor->isTileCopy(i)) {
+                weightTiles.push_back(
+                        { tiledTensor, i, getPackedName(op, tiledTensor, i) });
+            }
+        }
+    }
+    return weightTiles;
+}
+
+}  // namespace
+
+int packWeights(Network* network, const std::string& path) {
+    std::vector<WeightTile> weightTiles = findWeightTiles(network);
+    std::vector<Tensor*> tiles;
+    std::vector<std::string> names;
+    for (auto& weightTile : weightTiles) {
+        weightTile.tiledTensor->copyDataToAllTiles();
+        tiles.push_back((*weightTile.tiledTensor)[weightTile.index]);
+        names.push_back(weightTile.name);
+    }
+    if (!ParamFile::save(path, tiles, names))
+        return -1;
+    return tiles.size();
+}
+
+int mapPackedWeights(Network* network, const std::string& path) {
+    ParamFile paramFile;
+    if (!ParamFile::isParamFile(path) || !paramFile.load(path))
+        return -1;
+    std::vector<WeightTile> weightTiles = findWeightTiles(network);
+    for (auto& weightTile : weightTiles) {
+        if (!paramFile.contains(weightTile.name))
+            return -1;
+    }
+    for (auto& weightTile : weightTiles) {
+        TiledTensor* tiledTensor = weightTile.tiledTensor;
+        Tensor* tile = (*tiledTensor)[weightTile.index];
+        tiledTensor->setPackedTile(
+                weightTile.index,
+                paramFile.getTensorData(weightTile.name, *tile));
+    }
+    return weightTiles.size();
+}
+
+}  // namespace smaug
@@ -0,0 +1,43 @@
+#ifndef _CORE_PACKED_WEIGHTS_H_
+#define _CORE_PACKED_WEIGHTS_H_
+
+#include <string>
+
+#include "smaug/core/network.h"
+
+namespace smaug {
+
+/**
+ * Weight packing stores the weights of a Network already split into the tiles
+ * that the operators' tiling plans picked (see Operator::getTiledWeights()),
+ * in a raw parameters file (see ParamFile). Mapping such a file gives every
+ * weight tile its data directly, so preparing the constant weights is taken
+ * off the path of running the Network.
+ *
+ * Every tile is stored under the name of its operator, its index, shape and
+ * origin, so a file only matches a Network that is tiled the same way.
+ */
+
+/**
+ * Fills the weight tiles of all the operators in the Network and writes them
+ * to the given file. The operators must have been tiled.
+ *
+ * @returns The number of weight tiles written, or -1 if the file can't be
+ * written.
+ */
+int packWeights(Network* network, const std::string& path);
+
+/**
+ * Makes the weight tiles of all the operators in the Network use the packed
+ * data in the given file. The operators must have been tiled.
+ *
+ * Nothing is mapped unless the file has every weight tile of the Network.
+ *
+ * @returns The number of weight tiles mapped, or -1 if the file can't be
+ * read or doesn't match the Network.
+ */
+int mapPackedWeights(Network* network, const std::string& path);
+
+}  // namespace smaug
+
+#endif
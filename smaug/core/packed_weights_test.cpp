@@ -0,0 +1,71 @@
+#include <cstdio>
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/packed_weights.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor_utils.h"
+#include "smaug/operators/smv/smv_inner_product_op.h"
+#include "smaug/operators/smv/smv_test_common.h"
+
+using namespace smaug;
+
+class PackedWeightsTest : public SmaugTest {
+   public:
+    SmvInnerProductOp* addInnerProductOp(const std::string& name,
+                                         int inputSize,
+                                         int numNeurons) {
+        auto fcOp = new SmvInnerProductOp(name, workspace());
+        TensorShape inputShape(
+                { 1, inputSize }, DataLayout::NC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor(name + "/input", inputShape);
+        workspace()->addTensor(inputs);
+        fcOp->setInput(inputs, 0);
+        fcOp->setNumOutputs(numNeurons);
+        inputs->allocateStorage<float16>();
+        createAndFillTensorsWithData<float16>(fcOp, fillTensorWithRandomData);
+        network()->addOperator(fcOp);
+        return fcOp;
+    }
+};
+
+TEST_CASE_METHOD(PackedWeightsTest, "Packed weight tiles", "[packing]") {
+    char pathTemplate[] = "/tmp/smaug_packed_XXXXXX";
+    close(mkstemp(pathTemplate));
+    std::string path = pathTemplate;
+
+    // The weights are tiled into 16 neuron-wise and 2 activation-wise tiles.
+    SmvInnerProductOp* fcOp = addInnerProductOp("fc", 4096, 128);
+    fcOp->tile();
+    fcOp->run();
+    Tensor* output = fcOp->getOutput(0);
+    Tensor expected("expected", output->getShape());
+    expected.allocateStorage<float16>();
+    copyRawTensorData(
+            &expected, output, 0, 0, output->getShape().storageSize());
+
+    int numTiles = packWeights(network(), path);
+    REQUIRE(numTiles == 32);
+
+    SECTION("Packed tiles are used instead of the weights") {
+        // Start over with empty tiles.
+        fcOp->tile();
+        REQUIRE(mapPackedWeights(network(), path) == numTiles);
+        // The weights are never read again.
+        Tensor* weights = fcOp->getInput(1);
+        float16* weightsData = weights->data<float16>();
+        for (int i = 0; i < weights->getShape().storageSize(); i++)
+            weightsData[i] = 0;
+        fcOp->run();
+        verifyOutputs<float16>(output, &expected);
+    }
+
+    SECTION("Packed files only match the same tiling") {
+        addInnerProductOp("fc2", 4096, 128)->tile();
+        REQUIRE(mapPackedWeights(network(), path) == -1);
+        REQUIRE(mapPackedWeights(network(), path + ".missing") == -1);
+    }
+
+    std::remove(path.c_str());
+}
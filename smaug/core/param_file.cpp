@@ -0,0 +1,188 @@
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "smaug/core/param_file.h"
+#include "smaug/operators/common.h"
+
+namespace smaug {
+
+constexpr char ParamFile::kMagic[];
+constexpr uint32_t ParamFile::kVersion;
+constexpr size_t ParamFile::kBlobAlignment;
+
+namespace {
+
+const size_t kMagicSize = sizeof(ParamFile::kMagic) - 1;
+
+/** Reads a field of type T at offset, advancing it. */
+template <typename T>
+bool readField(const char* file, size_t fileSize, size_t& offset, T* value) {
+    if (offset + sizeof(T) > fileSize)
+        return false;
+    std::memcpy(value, file + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+template <typename T>
+void writeField(std::ofstream& file, T value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}  // namespace
+
+bool ParamFile::isParamFile(const std::string& path) {
+    char magic[kMagicSize];
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.read(magic, kMagicSize))
+        return false;
+    return std::memcmp(magic, kMagic, kMagicSize) == 0;
+}
+
+bool ParamFile::load(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size < kMagicSize) {
+        close(fd);
+        return false;
+    }
+    size_t fileSize = fileStat.st_size;
+    // Tensors like the network inputs are written to, so the mapping is
+    // writable, but private to this process.
+    void* addr = mmap(nullptr, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                      fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+    mapping = std::shared_ptr<char>(
+            reinterpret_cast<char*>(addr),
+            [fileSize](char* ptr) { munmap(ptr, fileSize); });
+    mappingSize = fileSize;
+
+    const char* file = mapping.get();
+    size_t offset = kMagicSize;
+    uint32_t version, numTensors;
+    if (std::memcmp(file, kMagic, kMagicSize) != 0 ||
+        !readField(file, fileSize, offset, &version) || version != kVersion ||
+        !readField(file, fileSize, offset, &numTensors))
+        return false;
+    for (uint32_t i = 0; i < numTensors; i++) {
+        uint32_t nameLength;
+        int32_t dataType;
+        Entry entry;
+        if (!readField(file, fileSize, offset, &nameLength) ||
+            offset + nameLength > fileSize)
+            return false;
+        std::string name(file + offset, nameLength);
+        offset += nameLength;
+        if (!readField(file, fileSize, offset, &dataType) ||
+            !readField(file, fileSize, offset, &entry.offset) ||
+            !readField(file, fileSize, offset, &entry.size) ||
+            entry.offset + entry.size > fileSize)
+            return false;
+        entry.dataType = static_cast<DataType>(dataType);
+        entries[name] = entry;
+    }
+    return true;
+}
+
+std::shared_ptr<void> ParamFile::getTensorData(
+        const std::string& name, const TensorBase& tensor) const {
+    auto it = entries.find(name);
+    assert(it != entries.end() && "The tensor is not in the parameters file!");
+    const Entry& entry = it->second;
+    assert(entry.dataType == tensor.getDataType() &&
+           "The tensor in the parameters file has a different data type!");
+    assert(entry.size >= tensor.getShape().storageSize() *
+                                 tensor.getDataTypeSize() &&
+           "The tensor in the parameters file is too small!");
+    // The aliasing constructor shares the ownership of the mapping.
+    return std::shared_ptr<void>(mapping, mapping.get() + entry.offset);
+}
+
+bool ParamFile::isMapped(const Tensor* tensor) const {
+    const char* data =
+            reinterpret_cast<const char*>(tensor->getStorage().get());
+    return mapping && data >= mapping.get() &&
+           data < mapping.get() + mappingSize;
+}
+
+void ParamFile::prefetch(const Tensor* tensor) const {
+    uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(tensor->getStorage().get());
+    uintptr_t end = begin + tensor->getShape().storageSize() *
+                                    tensor->getDataTypeSize();
+    // Cover every page the Tensor touches.
+    begin = begin / pageSize * pageSize;
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_WILLNEED);
+}
+
+void ParamFile::release(const Tensor* tensor) const {
+    uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+    uintptr_t begin = reinterpret_cast<uintptr_t>(tensor->getStorage().get());
+    uintptr_t end = begin + tensor->getShape().storageSize() *
+                                    tensor->getDataTypeSize();
+    // Only drop the pages that hold no other Tensor, which may still be used
+    // or may have been written to.
+    begin = next_multiple(begin, pageSize);
+    end = end / pageSize * pageSize;
+    if (begin < end)
+        madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED);
+}
+
+bool ParamFile::save(const std::string& path,
+                     const std::vector<Tensor*>& tensors,
+                     const std::vector<std::string>& names) {
+    assert((names.empty() || names.size() == tensors.size()) &&
+           "Every Tensor must be given a name!");
+    std::vector<std::string> entryNames = names;
+    if (entryNames.empty()) {
+        for (Tensor* tensor : tensors)
+            entryNames.push_back(tensor->getName());
+    }
+    std::ofstream file(path, std::ios::out | std::ios::binary);
+    if (!file)
+        return false;
+    size_t headerSize = kMagicSize + 2 * sizeof(uint32_t);
+    for (const std::string& name : entryNames) {
+        headerSize += sizeof(uint32_t) + name.size() + sizeof(int32_t) +
+                      2 * sizeof(uint64_t);
+    }
+    std::vector<uint64_t> offsets, sizes;
+    uint64_t offset = next_multiple(headerSize, kBlobAlignment);
+    for (Tensor* tensor : tensors) {
+        uint64_t size = tensor->getShape().storageSize() *
+                        tensor->getDataTypeSize();
+        offsets.push_back(offset);
+        sizes.push_back(size);
+        offset = next_multiple(offset + size, kBlobAlignment);
+    }
+
+    file.write(kMagic, kMagicSize);
+    writeField<uint32_t>(file, kVersion);
+    writeField<uint32_t>(file, tensors.size());
+    for (int i = 0; i < tensors.size(); i++) {
+        const std::string& name = entryNames[i];
+        writeField<uint32_t>(file, name.size());
+        file.write(name.data(), name.size());
+        writeField<int32_t>(file, tensors[i]->getDataType());
+        writeField<uint64_t>(file, offsets[i]);
+        writeField<uint64_t>(file, sizes[i]);
+    }
+    for (int i = 0; i < tensors.size(); i++) {
+        // Seeking past the end of the file leaves a zero-filled gap.
+        file.seekp(offsets[i]);
+        file.write(reinterpret_cast<const char*>(
+                           tensors[i]->getStorage().get()),
+                   sizes[i]);
+    }
+    return static_cast<bool>(file);
+}
+
+}  // namespace smaug
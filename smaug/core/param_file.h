@@ -0,0 +1,120 @@
+#ifndef _CORE_PARAM_FILE_H_
+#define _CORE_PARAM_FILE_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "smaug/core/tensor.h"
+#include "smaug/core/types.pb.h"
+
+namespace smaug {
+
+/**
+ * A model parameters file in the raw format, as an alternative to a
+ * serialized TensorDataArray.
+ *
+ * The file starts with a header that lists every tensor by name, followed by
+ * the raw contents of the tensors, each aligned to kBlobAlignment bytes:
+ *
+ *   char[8]  magic ("SMAUGRAW")
+ *   uint32   version
+ *   uint32   number of tensors
+ *   For each tensor:
+ *     uint32  length of the name
+ *     char[]  name
+ *     int32   DataType
+ *     uint64  offset of the contents from the start of the file
+ *     uint64  size of the contents in bytes
+ *
+ * All fields are little endian. The contents of a tensor are laid out exactly
+ * like its storage, alignment padding included, so the file is memory mapped
+ * and its tensors use the mapping as their storage, without any copies or
+ * decoding. The mapping is private: writes to a tensor (like new inputs) are
+ * never written back to the file.
+ *
+ * Since pages of the file are only read in when they are first accessed, the
+ * mapped Tensors take no memory until their consumers run. The Scheduler can
+ * also prefetch and release them around their consumers (see lazyLoadParams).
+ */
+class ParamFile {
+   public:
+    static constexpr char kMagic[] = "SMAUGRAW";
+    static constexpr uint32_t kVersion = 1;
+    static constexpr size_t kBlobAlignment = 64;
+
+    ParamFile() : mappingSize(0) {}
+
+    /** Returns true if the file at the given path is in the raw format. */
+    static bool isParamFile(const std::string& path);
+
+    /**
+     * Maps the file at the given path. Returns false if it can't be read or
+     * isn't a valid raw parameters file.
+     */
+    bool load(const std::string& path);
+
+    /** Returns true if the file contains the named tensor. */
+    bool contains(const std::string& name) const {
+        return entries.find(name) != entries.end();
+    }
+
+    /**
+     * Returns the contents of the given Tensor in the file, to be used as its
+     * storage. The storage keeps the mapping alive. Assert-fails if the file
+     * has no such tensor, or if it has a different data type or is smaller
+     * than the Tensor's storage.
+     */
+    std::shared_ptr<void> getTensorData(const TensorBase& tensor) const {
+        return getTensorData(tensor.getName(), tensor);
+    }
+
+    /**
+     * Same as above, but for a Tensor that is stored under the given name.
+     */
+    std::shared_ptr<void> getTensorData(const std::string& name,
+                                        const TensorBase& tensor) const;
+
+    /** Returns true if the Tensor's storage is in this file's mapping. */
+    bool isMapped(const Tensor* tensor) const;
+
+    /**
+     * Asks the OS to start reading the contents of the Tensor into memory,
+     * ahead of their use.
+     */
+    void prefetch(const Tensor* tensor) const;
+
+    /**
+     * Drops the memory pages that hold nothing but the contents of the Tensor.
+     * The Tensor keeps its storage: the pages are read from the file again on
+     * the next access. Anything written to them is lost, so this is only for
+     * Tensors that are not written to, or not read again.
+     */
+    void release(const Tensor* tensor) const;
+
+    /**
+     * Writes the contents of the given Tensors to a raw parameters file. They
+     * are stored under the given names, or their own names if there are none.
+     */
+    static bool save(const std::string& path,
+                     const std::vector<Tensor*>& tensors,
+                     const std::vector<std::string>& names = {});
+
+   protected:
+    struct Entry {
+        DataType dataType;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    std::map<std::string, Entry> entries;
+    /** The memory mapping of the whole file. */
+    std::shared_ptr<char> mapping;
+    size_t mappingSize;
+};
+
+}  // namespace smaug
+
+#endif
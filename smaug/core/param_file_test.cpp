@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/network_builder.h"
+#include "smaug/core/param_file.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor_utils.h"
+#include "smaug/operators/smv/smv_test_common.h"
+
+using namespace smaug;
+
+TEST_CASE_METHOD(SmaugTest, "Raw parameters files", "[params]") {
+    char pathTemplate[] = "/tmp/smaug_params_XXXXXX";
+    close(mkstemp(pathTemplate));
+    std::string path = pathTemplate;
+
+    SECTION("Tensors are mapped without copies") {
+        TensorShape floatShape({ 2, 5 }, DataLayout::NC, 8);
+        Tensor floatTensor("float", floatShape);
+        float* floatData = floatTensor.allocateStorage<float>();
+        for (int i = 0; i < floatShape.storageSize(); i++)
+            floatData[i] = i * 0.5;
+        TensorShape halfShape({ 3, 3 }, DataLayout::NC, 8);
+        Tensor halfTensor("half", halfShape);
+        halfTensor.allocateStorage<float16>();
+        fillTensorWithRandomData(&halfTensor);
+        REQUIRE(ParamFile::save(path, { &floatTensor, &halfTensor }));
+        REQUIRE(ParamFile::isParamFile(path));
+
+        ParamFile paramFile;
+        REQUIRE(paramFile.load(path));
+        REQUIRE(paramFile.contains("float"));
+        REQUIRE(paramFile.contains("half"));
+        REQUIRE(!paramFile.contains("other"));
+
+        Tensor mappedFloat("float", floatShape);
+        mappedFloat.setDataType(Float32);
+        std::shared_ptr<void> floatStorage =
+                paramFile.getTensorData(mappedFloat);
+        mappedFloat.setStorage(floatStorage);
+        REQUIRE(reinterpret_cast<uintptr_t>(floatStorage.get()) %
+                        ParamFile::kBlobAlignment ==
+                0);
+        verifyOutputs<float>(&mappedFloat, &floatTensor);
+
+        Tensor mappedHalf("half", halfShape);
+        mappedHalf.setDataType(Float16);
+        mappedHalf.setStorage(paramFile.getTensorData(mappedHalf));
+        verifyOutputs<float16>(&mappedHalf, &halfTensor);
+
+        // Writes to the mapped tensors don't go back to the file.
+        mappedFloat.data<float>()[0] = 12345;
+        ParamFile reloaded;
+        REQUIRE(reloaded.load(path));
+        Tensor reloadedFloat("float", floatShape);
+        reloadedFloat.setDataType(Float32);
+        reloadedFloat.setStorage(reloaded.getTensorData(reloadedFloat));
+        verifyOutputs<float>(&reloadedFloat, &floatTensor);
+    }
+
+    SECTION("Released tensors are read from the file again") {
+        TensorShape shape({ 64, 1024 }, DataLayout::NC);
+        Tensor tensor("weights", shape);
+        float* data = tensor.allocateStorage<float>();
+        for (int i = 0; i < shape.storageSize(); i++)
+            data[i] = i;
+        REQUIRE(ParamFile::save(path, { &tensor }));
+        ParamFile paramFile;
+        REQUIRE(paramFile.load(path));
+        Tensor mapped("weights", shape);
+        mapped.setDataType(Float32);
+        mapped.setStorage(paramFile.getTensorData(mapped));
+        REQUIRE(paramFile.isMapped(&mapped));
+        REQUIRE(!paramFile.isMapped(&tensor));
+        paramFile.prefetch(&mapped);
+        verifyOutputs<float>(&mapped, &tensor);
+        paramFile.release(&mapped);
+        verifyOutputs<float>(&mapped, &tensor);
+    }
+
+    SECTION("Networks are built from raw parameters files") {
+        std::string modelPath = "smaug/python/test_inputs/";
+        Network* network = buildNetwork(modelPath + "fp16_odd_odd_topo.txt",
+                                        modelPath + "fp16_odd_odd_params.pb");
+        Tensor* expected = network->getOperator("input")->getInput(0);
+        REQUIRE(ParamFile::save(path, { expected }));
+        REQUIRE(!ParamFile::isParamFile(
+                resolvePath(modelPath + "fp16_odd_odd_params.pb")));
+
+        Workspace workspace;
+        SamplingInfo sampling = { NoSampling, 1 };
+        Network* rawNetwork = smaug::buildNetwork(
+                resolvePath(modelPath + "fp16_odd_odd_topo.txt"), path,
+                sampling, &workspace);
+        Tensor* input = rawNetwork->getOperator("input")->getInput(0);
+        verifyOutputs<float16>(input, expected);
+        delete rawNetwork;
+    }
+
+    std::remove(path.c_str());
+}
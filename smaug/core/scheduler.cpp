@@ -1,9 +1,13 @@
 #include <iostream>
+#include <map>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "smaug/utility/debug_stream.h"
 #include "smaug/utility/thread_pool.h"
+#include "smaug/core/globals.h"
+#include "smaug/core/packed_weights.h"
 #include "smaug/core/tensor.h"
 #include "smaug/core/types.pb.h"
 #include "smaug/core/scheduler.h"
@@ -11,6 +15,33 @@
 namespace smaug {
 
 Tensor* Scheduler::runNetwork() {
+    if (!tiled)
+        tileNetwork();
+
+    std::cout << "======================================================\n";
+    std::cout << "      Scheduling operators of the network...\n";
+    std::cout << "======================================================\n";
+    // Clear the state left behind by any previous run.
+    for (auto& step : plan) {
+        for (auto output : step.outputs) {
+            if (output)
+                output->setDead(false);
+        }
+    }
+    if (allocateTensorsOnDemand)
+        findOnDemandTensors();
+    if (lazyLoadParams)
+        findLazyParams();
+    Tensor* output;
+    {
+        auto stats =
+                gem5::ScopedStats(stats::kNetworkStart, stats::kNetworkEnd);
+        output = scheduleReady();
+    }
+    return output;
+}
+
+void Scheduler::tileNetwork() {
     std::cout << "======================================================\n";
     std::cout << "      Tiling operators of the network...\n";
     std::cout << "======================================================\n";
@@ -20,6 +51,10 @@ Tensor* Scheduler::runNetwork() {
                 << OpType_Name(op->getOpType()) << ").\n";
         op->tile();
     }
+    forwardTiledTensors();
+    if (!packedWeightsFile.empty())
+        preparePackedWeights();
+    compilePlan();
 
     // We have finished loading the model and building the network, as well as
     // the tiling of all the operators. Now we can stop fast forwarding.
@@ -33,66 +68,304 @@ Tensor* Scheduler::runNetwork() {
     // incorrect.
     if (threadPool)
         threadPool->initThreadPool();
+    tiled = true;
+}
 
-    std::cout << "======================================================\n";
-    std::cout << "      Scheduling operators of the network...\n";
-    std::cout << "======================================================\n";
-    // Initialize number of pending inputs for every operator and put Data
-    // operators into the ready queue.
+void Scheduler::forwardTiledTensors() {
+    const Graph& graph = network->getGraph();
+    EdgeNameMap edges = get(boost::edge_name, graph);
+    for (auto nameOp : network->getOperators()) {
+        Operator* producer = nameOp.second;
+        // Group the consumers of this operator by the output they read.
+        std::map<int, std::vector<Edge>> outputConsumers;
+        out_edge_iter outEdgeIt, outEdgeEnd;
+        for (boost::tie(outEdgeIt, outEdgeEnd) =
+                     out_edges(producer->getVertex(), graph);
+             outEdgeIt != outEdgeEnd;
+             ++outEdgeIt) {
+            outputConsumers[edges[*outEdgeIt].srcIdx].push_back(*outEdgeIt);
+        }
+        for (auto& outputEdges : outputConsumers) {
+            // The original tensor is never filled once its tiles are
+            // forwarded, so it must have no other readers.
+            if (outputEdges.second.size() != 1)
+                continue;
+            const Edge& edge = outputEdges.second[0];
+            Operator* consumer =
+                    get(boost::vertex_op, graph, target(edge, graph));
+            TiledTensor* producerTiles =
+                    producer->getTiledOutput(edges[edge].srcIdx);
+            TiledTensor* consumerTiles =
+                    consumer->getTiledInput(edges[edge].destIdx);
+            if (!producerTiles || !consumerTiles || producerTiles->size() == 1 ||
+                !producerTiles->hasSameTiling(*consumerTiles))
+                continue;
+            dout(1) << "Forwarding tiles from " << producer->getName() << " to "
+                    << consumer->getName() << ".\n";
+            producerTiles->forwardTilesTo(*consumerTiles);
+        }
+    }
+}
+
+void Scheduler::preparePackedWeights() {
+    int numTiles = mapPackedWeights(network, packedWeightsFile);
+    if (numTiles >= 0) {
+        std::cout << "Mapped " << numTiles << " packed weight tiles from "
+                  << packedWeightsFile << ".\n";
+        return;
+    }
+    numTiles = packWeights(network, packedWeightsFile);
+    if (numTiles >= 0) {
+        std::cout << "Packed " << numTiles << " weight tiles into "
+                  << packedWeightsFile << ".\n";
+    } else {
+        std::cout << "Unable to write the packed weights to "
+                  << packedWeightsFile << "!\n";
+    }
+}
+
+void Scheduler::compilePlan() {
+    const Graph& graph = network->getGraph();
+    EdgeNameMap edges = get(boost::edge_name, graph);
+    std::vector<Operator*> order;
+    std::map<Operator*, int> numPendingInputs;
     for (auto nameOp : network->getOperators()) {
         Operator* op = nameOp.second;
-        Vertex vertex = op->getVertex();
-        int numPendingInputs = boost::in_degree(vertex, network->getGraph());
-        op->setNumPendingInputs(numPendingInputs);
-        if (numPendingInputs == 0)
-            readyQueue.push_back(op);
+        numPendingInputs[op] = boost::in_degree(op->getVertex(), graph);
+        if (numPendingInputs[op] == 0)
+            order.push_back(op);
     }
-    Tensor* output;
-    {
-        auto stats =
-                gem5::ScopedStats(stats::kNetworkStart, stats::kNetworkEnd);
-        output = scheduleReady();
+    for (int i = 0; i < order.size(); i++) {
+        out_edge_iter outEdgeIt, outEdgeEnd;
+        for (boost::tie(outEdgeIt, outEdgeEnd) =
+                     out_edges(order[i]->getVertex(), graph);
+             outEdgeIt != outEdgeEnd;
+             ++outEdgeIt) {
+            Operator* child =
+                    get(boost::vertex_op, graph, target(*outEdgeIt, graph));
+            if (--numPendingInputs[child] == 0)
+                order.push_back(child);
+        }
+    }
+    assert(order.size() == network->getOperators().size() &&
+           "The network contains a cycle!");
+
+    std::map<Operator*, int> stepIndex;
+    for (int i = 0; i < order.size(); i++)
+        stepIndex[order[i]] = i;
+    plan.clear();
+    plan.resize(order.size());
+    for (int i = 0; i < order.size(); i++) {
+        ExecutionStep& step = plan[i];
+        step.op = order[i];
+        for (auto output : step.op->getOutputs())
+            step.outputs.push_back(dynamic_cast<Tensor*>(output));
+        in_edge_iter inEdgeIt, inEdgeEnd;
+        for (boost::tie(inEdgeIt, inEdgeEnd) =
+                     in_edges(step.op->getVertex(), graph);
+             inEdgeIt != inEdgeEnd;
+             ++inEdgeIt) {
+            Operator* producer =
+                    get(boost::vertex_op, graph, source(*inEdgeIt, graph));
+            step.inputs.push_back(
+                    producer->getOutput(edges[*inEdgeIt].srcIdx));
+        }
+        out_edge_iter outEdgeIt, outEdgeEnd;
+        for (boost::tie(outEdgeIt, outEdgeEnd) =
+                     out_edges(step.op->getVertex(), graph);
+             outEdgeIt != outEdgeEnd;
+             ++outEdgeIt) {
+            step.successors.push_back(stepIndex.at(
+                    get(boost::vertex_op, graph, target(*outEdgeIt, graph))));
+        }
     }
-    return output;
 }
 
 Tensor* Scheduler::scheduleReady() {
     Tensor* output;
-    for (auto op : readyQueue) {
-        dout(0) << "Scheduling " << op->getName() << " ("
-                << OpType_Name(op->getOpType()) << ").\n";
-        maybeRunOperator(op);
-        updateChildren(op);
-        output = op->getOutput(0);
+    for (auto& step : plan) {
+        dout(0) << "Scheduling " << step.op->getName() << " ("
+                << OpType_Name(step.op->getOpType()) << ").\n";
+        maybeRunOperator(step);
+        output = step.outputs[0];
         dout(2) << *output << "\n";
     }
     return output;
 }
 
-void Scheduler::maybeRunOperator(Operator* op) {
+void Scheduler::maybeRunOperator(const ExecutionStep& step) {
+    Operator* op = step.op;
     if (!op->isDead()) {
+        if (allocateTensorsOnDemand)
+            allocateOutputs(step);
+        if (lazyLoadParams)
+            pageInParams(step);
         op->run();
+        for (auto output : step.outputs)
+            output->markUpdated();
     } else {
-        for (auto output : op->getOutputs())
+        for (auto output : step.outputs)
             output->setDead();
     }
+    if (allocateTensorsOnDemand)
+        releaseInputs(step);
+    if (lazyLoadParams)
+        releaseParams(step);
 }
 
-void Scheduler::updateChildren(Operator* op) {
-    const Graph& graph = network->getGraph();
-    Vertex vertex = op->getVertex();
-    out_edge_iter outEdgeIt, outEdgeEnd;
-    for (boost::tie(outEdgeIt, outEdgeEnd) = out_edges(vertex, graph);
-         outEdgeIt != outEdgeEnd;
-         ++outEdgeIt) {
-        Vertex childVertex = target(*outEdgeIt, graph);
-        Operator* child = get(boost::vertex_op, graph, childVertex);
-        if (child->getNumPendingInputs() > 0) {
-            child->decrNumPendingInputs();
-            if (child->getNumPendingInputs() == 0)
-                readyQueue.push_back(child);
+void Scheduler::findOnDemandTensors() {
+    numPendingConsumers.clear();
+    for (auto& step : plan) {
+        for (auto output : step.outputs) {
+            if (output && !output->containsData() &&
+                output->getDataType() != UnknownDataType) {
+                numPendingConsumers[output] = 0;
+                // The storage is freed and allocated again on every run.
+                output->setAllocator(workspace->getPool());
+            }
+        }
+    }
+    for (auto& step : plan) {
+        for (auto input : step.inputs) {
+            auto it = numPendingConsumers.find(input);
+            if (it != numPendingConsumers.end())
+                it->second++;
+        }
+    }
+}
+
+void Scheduler::allocateOutputs(const ExecutionStep& step) {
+    for (auto output : step.outputs) {
+        if (numPendingConsumers.count(output))
+            output->allocateStorage(output->getDataType());
+    }
+}
+
+void Scheduler::releaseInputs(const ExecutionStep& step) {
+    std::lock_guard<std::mutex> lock(consumersMutex);
+    for (auto input : step.inputs) {
+        auto it = numPendingConsumers.find(input);
+        if (it != numPendingConsumers.end() && --it->second == 0) {
+            dout(1) << "Freeing " << input->getName() << ".\n";
+            input->freeStorage();
         }
     }
+    for (auto output : step.outputs) {
+        if (numPendingConsumers.count(output) && output->isDead())
+            output->freeStorage();
+    }
+}
+
+void Scheduler::findLazyParams() {
+    numPendingParamConsumers.clear();
+    ParamFile* paramFile = workspace->getParamFile();
+    if (!paramFile)
+        return;
+    for (auto& step : plan) {
+        for (auto input : step.inputs) {
+            if (input && input->containsData() && paramFile->isMapped(input))
+                numPendingParamConsumers[input]++;
+        }
+    }
+}
+
+void Scheduler::pageInParams(const ExecutionStep& step) {
+    ParamFile* paramFile = workspace->getParamFile();
+    if (numPendingParamConsumers.empty())
+        return;
+    for (auto input : step.inputs) {
+        if (numPendingParamConsumers.count(input))
+            paramFile->prefetch(input);
+    }
+    // Data operators have no inputs and run before everything else, so
+    // reading ahead from them would read in the whole file at once.
+    if (step.op->getOpType() == OpType::Data)
+        return;
+    for (int successor : step.successors) {
+        for (auto input : plan[successor].inputs) {
+            if (numPendingParamConsumers.count(input))
+                paramFile->prefetch(input);
+        }
+    }
+}
+
+void Scheduler::releaseParams(const ExecutionStep& step) {
+    if (!singleShot || numPendingParamConsumers.empty())
+        return;
+    std::lock_guard<std::mutex> lock(consumersMutex);
+    for (auto input : step.inputs) {
+        auto it = numPendingParamConsumers.find(input);
+        if (it != numPendingParamConsumers.end() && --it->second == 0) {
+            dout(1) << "Releasing " << input->getName() << ".\n";
+            workspace->getParamFile()->release(input);
+        }
+    }
+}
+
+Tensor* ConcurrentScheduler::scheduleReady() {
+    readyQueue.clear();
+    numUnfinishedOps = plan.size();
+    for (int i = 0; i < plan.size(); i++) {
+        plan[i].op->setNumPendingInputs(plan[i].inputs.size());
+        if (plan[i].inputs.empty())
+            readyQueue.push_back(i);
+    }
+    std::vector<std::thread> workers;
+    for (int i = 0; i < numWorkers; i++)
+        workers.emplace_back(&ConcurrentScheduler::workerLoop, this);
+    for (auto& worker : workers)
+        worker.join();
+    // The final output is the one the sequential Scheduler would return.
+    return plan.back().outputs[0];
+}
+
+void ConcurrentScheduler::workerLoop() {
+    while (true) {
+        int index;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCond.wait(lock, [this] {
+                return !readyQueue.empty() || numUnfinishedOps == 0;
+            });
+            if (numUnfinishedOps == 0)
+                return;
+            index = readyQueue.front();
+            readyQueue.pop_front();
+        }
+        const ExecutionStep& step = plan[index];
+        Operator* op = step.op;
+        dout(0) << "Scheduling " << op->getName() << " ("
+                << OpType_Name(op->getOpType()) << ").\n";
+        if (op->isHostOnly()) {
+            maybeRunOperator(step);
+        } else {
+            std::lock_guard<std::mutex> guard(acceleratorMutex);
+            maybeRunOperator(step);
+        }
+        updateChildren(step);
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            if (--numUnfinishedOps == 0)
+                queueCond.notify_all();
+        }
+    }
+}
+
+void ConcurrentScheduler::updateChildren(const ExecutionStep& step) {
+    for (int successor : step.successors) {
+        Operator* child = plan[successor].op;
+        if (child->getNumPendingInputs() > 0 &&
+            child->decrNumPendingInputs() == 0)
+            addToReadyQueue(successor);
+    }
+}
+
+void ConcurrentScheduler::addToReadyQueue(int step) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        readyQueue.push_back(step);
+    }
+    queueCond.notify_one();
 }
 
 }  // namespace smaug
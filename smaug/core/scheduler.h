@@ -1,4 +1,9 @@
+#include <condition_variable>
 #include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
 
 #include "smaug/core/network.h"
 #include "smaug/core/workspace.h"
@@ -6,23 +11,86 @@
 
 namespace smaug {
 
+/**
+ * ExecutionStep is one Operator of a compiled execution plan, with everything
+ * needed to schedule it resolved ahead of time.
+ */
+struct ExecutionStep {
+    Operator* op;
+    /** The outputs of op. Null for outputs it does not produce. */
+    std::vector<Tensor*> outputs;
+    /** The producer output carried by every incoming edge of op. */
+    std::vector<Tensor*> inputs;
+    /** The step index of the consumer on every outgoing edge of op. */
+    std::vector<int> successors;
+};
+
 /**
  * Scheduler is responsible for running the Network.
+ *
+ * Before the first run, the Network is compiled into a static execution plan:
+ * a flat array of ExecutionSteps in the order that the operators are run in.
+ * Later runs just walk this array, without traversing the graph again.
  */
 class Scheduler {
    public:
     Scheduler(Network* _network, Workspace* _workspace)
-            : network(_network), workspace(_workspace) {}
+            : network(_network), workspace(_workspace), tiled(false),
+              singleShot(false) {}
     virtual ~Scheduler(){};
-    /** Runs the Network to completion. The final output tensor is returned. */
+    /**
+     * Runs the Network to completion. The final output tensor is returned.
+     *
+     * The operators are tiled on the first call only. Later calls run the
+     * Network again with the same tiles, picking up any new contents of the
+     * input tensors (see Tensor::markUpdated()).
+     */
     Tensor* runNetwork();
 
+    /**
+     * Declares that the Network is run only once, so the weights that are
+     * loaded lazily (see lazyLoadParams) can be dropped after use.
+     */
+    void setSingleShot(bool _singleShot) { singleShot = _singleShot; }
+
+    /**
+     * Sets the file of packed weight tiles (see packWeights()). When the
+     * Network is tiled, its weight tiles are mapped from this file if it
+     * matches the tiling; otherwise, they are packed into it.
+     */
+    void setPackedWeightsFile(const std::string& path) {
+        packedWeightsFile = path;
+    }
+
    protected:
     /**
-     * Runs the operators in the ready queue. This may add new operators to
-     * the ready queue by calling updateChildren().
+     * Tiles all the operators and finishes fast-forwarding. This is done once,
+     * before the first run.
+     */
+    void tileNetwork();
+
+    /**
+     * Lets consumers work directly on the output tiles of their producer when
+     * both tile the Tensor between them in the same way, instead of the
+     * producer untiling it and the consumer tiling it again.
+     */
+    void forwardTiledTensors();
+
+    /**
+     * Maps the weight tiles from the packed weights file, or packs them into
+     * it if it doesn't match the Network.
+     */
+    void preparePackedWeights();
+
+    /**
+     * Flattens the Network into the execution plan. The steps are ordered the
+     * way a ready queue seeded with the operators that have no inputs would
+     * visit them, so every step comes after all of its producers.
      */
-    Tensor* scheduleReady();
+    void compilePlan();
+
+    /** Runs all the steps of the execution plan. */
+    virtual Tensor* scheduleReady();
 
     /**
      * If none of the inputs to the current Operator are dead, then this will
@@ -30,20 +98,124 @@ class Scheduler {
      * will be marked as dead tensors. The only exception is MergeOp, which can
      * run with dead inputs.
      */
-    void maybeRunOperator(Operator* op);
+    void maybeRunOperator(const ExecutionStep& step);
+
+    /**
+     * Finds the operator outputs that have no storage yet and counts their
+     * consumers. These are allocated by allocateOutputs() and freed by
+     * releaseInputs().
+     */
+    void findOnDemandTensors();
+
+    /** Allocates the storage of the Operator's on-demand outputs. */
+    void allocateOutputs(const ExecutionStep& step);
+
+    /**
+     * Called once an Operator has finished (or was found dead). Frees its
+     * on-demand inputs that have no more pending consumers, as well as any of
+     * its on-demand outputs that turned out dead.
+     */
+    void releaseInputs(const ExecutionStep& step);
+
+    /**
+     * Finds the inputs that are in the memory mapped parameters file and
+     * counts their consumers, for pageInParams() and releaseParams().
+     */
+    void findLazyParams();
+
+    /**
+     * Starts reading in the mapped inputs of the Operator, and those of the
+     * Operators that run after it, before they are needed.
+     */
+    void pageInParams(const ExecutionStep& step);
 
     /**
-     * After an Operator is run, this updates the number of pending inputs on
-     * all its children. Any child Operator with no more pending inputs is then
-     * added to the ready queue.
+     * In single-shot runs, drops the mapped inputs of the Operator that have
+     * no more pending consumers from memory.
      */
-    void updateChildren(Operator* op);
+    void releaseParams(const ExecutionStep& step);
 
     Network* network;
     Workspace* workspace;
 
-    /** The queue of all Operators ready to be executed. */
-    std::list<Operator*> readyQueue;
+    /** The execution plan, built by compilePlan(). */
+    std::vector<ExecutionStep> plan;
+
+    /** True once the operators have been tiled. */
+    bool tiled;
+
+    /**
+     * The number of consumers yet to finish for every tensor allocated on
+     * demand. Tensors without consumers are kept until the end.
+     */
+    std::map<Tensor*, int> numPendingConsumers;
+    /** Protects numPendingConsumers and numPendingParamConsumers. */
+    std::mutex consumersMutex;
+    /** See setSingleShot(). */
+    bool singleShot;
+    /** See setPackedWeightsFile(). */
+    std::string packedWeightsFile;
+    /**
+     * The number of consumers yet to run for every input that is in the
+     * memory mapped parameters file.
+     */
+    std::map<Tensor*, int> numPendingParamConsumers;
+};
+
+/**
+ * ConcurrentScheduler runs all ready Operators of the Network in parallel on a
+ * set of worker threads.
+ *
+ * Independent branches of the graph (e.g. Inception-style towers, both sides
+ * of a SwitchOp, or the per-timestep chains of an unrolled LSTM) are executed
+ * concurrently, so a wide graph finishes in close to its critical path time.
+ * Operators that invoke accelerator kernels are still serialized with respect
+ * to each other (see Operator::isHostOnly()), but they can overlap with any
+ * host-only Operator.
+ *
+ * The output returned is the same as the sequential Scheduler's: the output of
+ * the Operator that would have been scheduled last.
+ */
+class ConcurrentScheduler : public Scheduler {
+   public:
+    ConcurrentScheduler(Network* _network,
+                        Workspace* _workspace,
+                        int _numWorkers)
+            : Scheduler(_network, _workspace), numWorkers(_numWorkers),
+              numUnfinishedOps(0) {}
+
+   protected:
+    Tensor* scheduleReady() override;
+
+    /**
+     * The event loop executed by every worker thread: pop a step off the
+     * ready queue, run it, and update its successors, until every Operator
+     * in the Network has finished.
+     */
+    void workerLoop();
+
+    /**
+     * After a step has run, this updates the number of pending inputs of all
+     * its successors. Any successor with no more pending inputs is then added
+     * to the ready queue.
+     */
+    void updateChildren(const ExecutionStep& step);
+
+    /** Adds a step whose inputs are all available to the ready queue. */
+    void addToReadyQueue(int step);
+
+    /** The indices of all steps ready to be executed. */
+    std::list<int> readyQueue;
+    /** Number of worker threads. */
+    int numWorkers;
+    /** The number of Operators that have not finished running. */
+    int numUnfinishedOps;
+    /** Protects readyQueue and numUnfinishedOps. */
+    std::mutex queueMutex;
+    /** Signaled when an Operator becomes ready or all Operators finish. */
+    std::condition_variable queueCond;
+    /** Held while running any Operator that is not host-only. */
+    std::mutex acceleratorMutex;
 };
 
 }  // namespace smaug
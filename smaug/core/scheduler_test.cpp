@@ -0,0 +1,220 @@
+#include <cstdio>
+#include <memory>
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
+#include "smaug/core/param_file.h"
+#include "smaug/core/scheduler.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/operators/control_flow_ops.h"
+#include "smaug/operators/data_op.h"
+#include "smaug/operators/eltwise_add_op.h"
+#include "smaug/operators/relu_op.h"
+#include "smaug/operators/reshape_op.h"
+
+using namespace smaug;
+
+class SchedulerTest : public SmaugTest {
+   public:
+    // Builds a network of kNumBranches independent data -> relu -> reshape
+    // branches, which are reduced pairwise by a tree of eltwise additions.
+    void buildBranchyNetwork() {
+        TensorShape shape({ 1, kNumElems }, DataLayout::NC);
+        std::vector<Operator*> level;
+        for (int i = 0; i < kNumBranches; i++) {
+            std::string suffix = std::to_string(i);
+            Tensor* input = new Tensor("input" + suffix, shape);
+            input->allocateStorage<float>();
+            std::vector<float> data(kNumElems);
+            for (int j = 0; j < kNumElems; j++)
+                data[j] = (j % 2 == 0 ? 1 : -1) * (i + j);
+            input->fillData(data.data(), data.size());
+            workspace()->addTensor(input);
+            auto dataOp = new DataOp<ReferenceBackend>(
+                    "data" + suffix, workspace());
+            dataOp->setData(input);
+            network()->addOperator(dataOp);
+
+            auto reluOp = new ReluOp<ReferenceBackend>(
+                    "relu" + suffix, workspace());
+            connect(dataOp, reluOp, 0);
+            auto reshapeOp = new ReshapeOp<ReferenceBackend>(
+                    "reshape" + suffix, workspace());
+            reshapeOp->setShape({ 1, kNumElems }, DataLayout::NC);
+            connect(reluOp, reshapeOp, 0);
+            level.push_back(reshapeOp);
+        }
+        int addId = 0;
+        while (level.size() > 1) {
+            std::vector<Operator*> nextLevel;
+            for (int i = 0; i < level.size(); i += 2) {
+                auto addOp = new EltwiseAddOp<ReferenceBackend>(
+                        "add" + std::to_string(addId++), workspace());
+                connect(level[i], addOp, 0);
+                connect(level[i + 1], addOp, 1);
+                nextLevel.push_back(addOp);
+            }
+            level = nextLevel;
+        }
+    }
+
+    std::vector<float> expectedOutput() const {
+        std::vector<float> expected(kNumElems, 0);
+        for (int i = 0; i < kNumBranches; i++) {
+            for (int j = 0; j < kNumElems; j++)
+                expected[j] += j % 2 == 0 ? i + j : 0;
+        }
+        return expected;
+    }
+
+   protected:
+    // Connects output srcIdx of src to the input of dest at destIdx. Once all
+    // of dest's inputs are connected, its output tensors are created. Their
+    // storage is left to the scheduler if it allocates tensors on demand.
+    void connect(Operator* src, Operator* dest, int destIdx, int srcIdx = 0) {
+        if (destIdx == 0)
+            network()->addOperator(dest);
+        dest->setInput(src->getOutput(srcIdx), destIdx);
+        network()->addEdge(src, dest, { srcIdx, destIdx });
+        if (destIdx == dest->getInputs().size() - 1) {
+            dest->createAllTensors();
+            for (auto output : dest->getOutputs()) {
+                Tensor* tensor = dynamic_cast<Tensor*>(output);
+                if (allocateTensorsOnDemand)
+                    tensor->setDataType(Float32);
+                else
+                    tensor->allocateStorage<float>();
+            }
+        }
+    }
+
+    DataOp<ReferenceBackend>* addData(Tensor* tensor) {
+        workspace()->addTensor(tensor);
+        auto dataOp = new DataOp<ReferenceBackend>(
+                tensor->getName() + "_data", workspace());
+        dataOp->setData(tensor);
+        network()->addOperator(dataOp);
+        return dataOp;
+    }
+
+    static constexpr int kNumBranches = 8;
+    static constexpr int kNumElems = 16;
+};
+
+TEST_CASE_METHOD(SchedulerTest, "Schedule a branchy network", "[scheduler]") {
+    buildBranchyNetwork();
+
+    SECTION("Sequential scheduler") {
+        Scheduler scheduler(network(), workspace());
+        Tensor* output = scheduler.runNetwork();
+        REQUIRE(output->getName() == "add6");
+        verifyOutputs(output, expectedOutput());
+    }
+
+    SECTION("Concurrent scheduler") {
+        for (int numWorkers : { 1, 2, 4 }) {
+            ConcurrentScheduler scheduler(network(), workspace(), numWorkers);
+            Tensor* output = scheduler.runNetwork();
+            REQUIRE(output->getName() == "add6");
+            verifyOutputs(output, expectedOutput());
+        }
+    }
+}
+
+TEST_CASE_METHOD(SchedulerTest, "Allocate tensors on demand", "[scheduler]") {
+    allocateTensorsOnDemand = true;
+    // input -> switch -> false: reluFalse ------------> merge -> reluOut
+    //                 -> true:  reluTrue0 -> reluTrue1 -^
+    std::vector<float> inputData(kNumElems);
+    std::vector<float> expected(kNumElems);
+    for (int i = 0; i < kNumElems; i++) {
+        inputData[i] = i % 2 == 0 ? i : -i;
+        expected[i] = i % 2 == 0 ? i : 0;
+    }
+    Tensor* input =
+            new Tensor("input", TensorShape({ 1, kNumElems }, DataLayout::NC));
+    input->allocateStorage<float>();
+    input->fillData(inputData.data(), inputData.size());
+    Tensor* pred = new Tensor("pred", TensorShape({ 1 }, DataLayout::N));
+    pred->allocateStorage<bool>();
+    pred->fillData({ true });
+    auto inputOp = addData(input);
+    auto predOp = addData(pred);
+    auto switchOp = new SwitchOp<ReferenceBackend>("switch", workspace());
+    connect(inputOp, switchOp, 0);
+    connect(predOp, switchOp, 1);
+    auto reluFalse = new ReluOp<ReferenceBackend>("reluFalse", workspace());
+    connect(switchOp, reluFalse, 0, 0);
+    auto reluTrue0 = new ReluOp<ReferenceBackend>("reluTrue0", workspace());
+    connect(switchOp, reluTrue0, 0, 1);
+    auto reluTrue1 = new ReluOp<ReferenceBackend>("reluTrue1", workspace());
+    connect(reluTrue0, reluTrue1, 0);
+    auto mergeOp = new MergeOp<ReferenceBackend>("merge", workspace());
+    mergeOp->setNumInputs(2);
+    connect(reluFalse, mergeOp, 0);
+    connect(reluTrue1, mergeOp, 1);
+    auto reluOut = new ReluOp<ReferenceBackend>("reluOut", workspace());
+    connect(mergeOp, reluOut, 0);
+
+    std::unique_ptr<Scheduler> scheduler;
+    SECTION("Sequential scheduler") {
+        scheduler.reset(new Scheduler(network(), workspace()));
+    }
+    SECTION("Concurrent scheduler") {
+        scheduler.reset(new ConcurrentScheduler(network(), workspace(), 2));
+    }
+    Tensor* output = scheduler->runNetwork();
+    REQUIRE(output == reluOut->getOutput(0));
+    verifyOutputs(output, expected);
+    // The untaken branch is never allocated.
+    REQUIRE(switchOp->getOutput(0)->isDead());
+    REQUIRE(!switchOp->getOutput(0)->containsData());
+    REQUIRE(reluFalse->getOutput(0)->isDead());
+    REQUIRE(!reluFalse->getOutput(0)->containsData());
+    // Intermediate tensors are freed after their last consumer.
+    REQUIRE(!switchOp->getOutput(1)->containsData());
+    REQUIRE(!reluTrue0->getOutput(0)->containsData());
+    REQUIRE(!reluTrue1->getOutput(0)->containsData());
+    REQUIRE(!mergeOp->getOutput(0)->containsData());
+    // The network inputs are left alone.
+    REQUIRE(inputOp->getOutput(0)->containsData());
+    allocateTensorsOnDemand = false;
+}
+
+TEST_CASE_METHOD(SchedulerTest, "Lazily load parameters", "[scheduler]") {
+    buildBranchyNetwork();
+    // Move the network inputs into a memory mapped parameters file.
+    char pathTemplate[] = "/tmp/smaug_params_XXXXXX";
+    close(mkstemp(pathTemplate));
+    std::vector<Tensor*> inputs;
+    for (int i = 0; i < kNumBranches; i++)
+        inputs.push_back(workspace()->getTensor("input" + std::to_string(i)));
+    REQUIRE(ParamFile::save(pathTemplate, inputs));
+    auto paramFile = std::make_shared<ParamFile>();
+    REQUIRE(paramFile->load(pathTemplate));
+    std::remove(pathTemplate);
+    for (auto input : inputs) {
+        input->freeStorage();
+        input->setStorage(paramFile->getTensorData(*input));
+    }
+    workspace()->setParamFile(paramFile);
+    lazyLoadParams = true;
+
+    std::unique_ptr<Scheduler> scheduler;
+    SECTION("Sequential scheduler") {
+        scheduler.reset(new Scheduler(network(), workspace()));
+    }
+    SECTION("Concurrent scheduler") {
+        scheduler.reset(new ConcurrentScheduler(network(), workspace(), 2));
+    }
+    scheduler->setSingleShot(true);
+    verifyOutputs(scheduler->runNetwork(), expectedOutput());
+    // Released inputs are read from the file again.
+    verifyOutputs(scheduler->runNetwork(), expectedOutput());
+    for (auto input : inputs)
+        REQUIRE(paramFile->isMapped(input));
+    lazyLoadParams = false;
+}
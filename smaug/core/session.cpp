@@ -0,0 +1,66 @@
+#include "smaug/core/session.h"
+#include "smaug/core/network_builder.h"
+#include "smaug/core/tensor_utils.h"
+
+namespace smaug {
+
+Session::Session(const std::string& modelTopo,
+                 const std::string& modelParams,
+                 SamplingInfo& sampling,
+                 int numSchedulerThreads)
+        : ownedWorkspace(new Workspace()), numRuns(0) {
+    workspace = ownedWorkspace.get();
+    ownedNetwork.reset(
+            buildNetwork(modelTopo, modelParams, sampling, workspace));
+    network = ownedNetwork.get();
+    createScheduler(numSchedulerThreads);
+}
+
+Session::Session(Network* _network,
+                 Workspace* _workspace,
+                 int numSchedulerThreads)
+        : network(_network), workspace(_workspace), numRuns(0) {
+    createScheduler(numSchedulerThreads);
+}
+
+Session::~Session() {
+    // The operators must be deleted before the tensors they refer to.
+    scheduler.reset();
+    ownedNetwork.reset();
+    ownedWorkspace.reset();
+}
+
+void Session::createScheduler(int numSchedulerThreads) {
+    if (numSchedulerThreads > 0) {
+        scheduler.reset(new ConcurrentScheduler(
+                network, workspace, numSchedulerThreads));
+    } else {
+        scheduler.reset(new Scheduler(network, workspace));
+    }
+}
+
+Tensor* Session::getInput(const std::string& dataOpName) {
+    Operator* dataOp = network->getOperator(dataOpName);
+    assert(dataOp->getOpType() == OpType::Data &&
+           "Inputs can only be set on data operators!");
+    return dataOp->getOutput(0);
+}
+
+void Session::setInput(const std::string& dataOpName, Tensor* data) {
+    Tensor* input = getInput(dataOpName);
+    assert(input->getShape() == data->getShape() &&
+           "The new input must have the same shape as the old one!");
+    assert(input->getDataType() == data->getDataType() &&
+           "The new input must have the same data type as the old one!");
+    copyRawTensorData(
+            input, data, 0, 0, input->getShape().storageSize());
+    input->markUpdated();
+}
+
+Tensor* Session::run() {
+    Tensor* output = scheduler->runNetwork();
+    numRuns++;
+    return output;
+}
+
+}  // namespace smaug
@@ -0,0 +1,99 @@
+#ifndef _CORE_SESSION_H_
+#define _CORE_SESSION_H_
+
+#include <memory>
+#include <string>
+
+#include "smaug/core/network.h"
+#include "smaug/core/scheduler.h"
+#include "smaug/core/tensor.h"
+#include "smaug/core/workspace.h"
+#include "smaug/operators/common.h"
+
+namespace smaug {
+
+/**
+ * Session builds a Network once and runs it on any number of inputs.
+ *
+ * The model protobufs are parsed, and the operators tiled, only once. Every
+ * run reuses the same operators, TiledTensors and tensor storage; only the
+ * contents of the inputs given to setInput() change between runs. This
+ * amortizes model loading and tiling across many inferences.
+ */
+class Session {
+   public:
+    /**
+     * Builds the Network from the given model topology and parameters
+     * protobufs. See buildNetwork().
+     *
+     * @param numSchedulerThreads If positive, run the Network with a
+     * ConcurrentScheduler using this many threads.
+     */
+    Session(const std::string& modelTopo,
+            const std::string& modelParams,
+            SamplingInfo& sampling,
+            int numSchedulerThreads = 0);
+
+    /**
+     * Runs an already built Network. The Session does not take ownership of
+     * the Network or Workspace.
+     */
+    Session(Network* _network,
+            Workspace* _workspace,
+            int numSchedulerThreads = 0);
+
+    ~Session();
+
+    /**
+     * Replaces the contents of the Tensor provided by the named DataOp with
+     * the contents of data, which must have the same shape and data type.
+     * The new contents are used from the next call to run() on.
+     */
+    void setInput(const std::string& dataOpName, Tensor* data);
+
+    /** Returns the Tensor provided by the named DataOp. */
+    Tensor* getInput(const std::string& dataOpName);
+
+    /**
+     * Runs the Network and returns its final output. The output Tensor is
+     * owned by the Session and is overwritten by the next run.
+     */
+    Tensor* run();
+
+    /**
+     * Declares that the Network is run only once. See
+     * Scheduler::setSingleShot().
+     */
+    void setSingleShot(bool singleShot) {
+        scheduler->setSingleShot(singleShot);
+    }
+
+    /**
+     * Maps the weight tiles from, or packs them into, the given file. See
+     * Scheduler::setPackedWeightsFile().
+     */
+    void setPackedWeightsFile(const std::string& path) {
+        scheduler->setPackedWeightsFile(path);
+    }
+
+    /** Returns the number of completed runs. */
+    int getNumRuns() const { return numRuns; }
+
+    Network* getNetwork() const { return network; }
+    Workspace* getWorkspace() const { return workspace; }
+
+   protected:
+    void createScheduler(int numSchedulerThreads);
+
+    Network* network;
+    Workspace* workspace;
+    /** Set if the Session built the Network and Workspace itself. */
+    std::unique_ptr<Network> ownedNetwork;
+    std::unique_ptr<Workspace> ownedWorkspace;
+    std::unique_ptr<Scheduler> scheduler;
+    int numRuns;
+};
+
+}  // namespace smaug
+
+#endif
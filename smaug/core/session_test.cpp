@@ -0,0 +1,98 @@
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/session.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/core/tensor_utils.h"
+#include "smaug/operators/data_op.h"
+#include "smaug/operators/smv/smv_convolution_op.h"
+#include "smaug/operators/smv/smv_relu_op.h"
+#include "smaug/operators/smv/smv_test_common.h"
+
+using namespace smaug;
+
+class SessionTest : public SmaugTest {
+   public:
+    // Builds data -> conv -> relu, where the convolution input is split into
+    // multiple tiles.
+    void buildConvNetwork() {
+        dataOp = new DataOp<SmvBackend>("data", workspace());
+        dataOp->setData(newInput("input"));
+        network()->addOperator(dataOp);
+
+        convOp = new SmvConvolutionOp("conv", workspace());
+        convOp->setStride(1, 1);
+        convOp->setPadding(SamePadding);
+        convOp->setWeightDims(1, 1, kChannels);
+        connect(dataOp, convOp);
+
+        auto reluOp = new SmvReluOp("relu", workspace());
+        connect(convOp, reluOp);
+    }
+
+    Tensor* newInput(const std::string& name) {
+        TensorShape shape({ 1, 32, 32, kChannels }, NHWC, SmvBackend::Alignment);
+        Tensor* input = new Tensor(name, shape);
+        input->allocateStorage<float16>();
+        fillTensorWithRandomData(input);
+        return workspace()->addTensor(input);
+    }
+
+    // Returns a copy of the tensor, since the session overwrites its output on
+    // every run.
+    Tensor* copyOf(Tensor* tensor, const std::string& name) {
+        Tensor* copy = new Tensor(name, tensor->getShape());
+        copy->allocateStorage<float16>();
+        copyRawTensorData(
+                copy, tensor, 0, 0, tensor->getShape().storageSize());
+        return workspace()->addTensor(copy);
+    }
+
+    bool isSame(Tensor* a, Tensor* b) {
+        float16* aData = a->data<float16>();
+        float16* bData = b->data<float16>();
+        for (int i = 0; i < a->getShape().storageSize(); i++) {
+            if (aData[i] != bData[i])
+                return false;
+        }
+        return true;
+    }
+
+   protected:
+    void connect(Operator* src, Operator* dest) {
+        network()->addOperator(dest);
+        dest->setInput(src->getOutput(0), 0);
+        network()->addEdge(src, dest, { 0, 0 });
+        createAndFillTensorsWithData<float16>(dest, fillTensorWithRandomData);
+    }
+
+    static constexpr int kChannels = 64;
+    DataOp<SmvBackend>* dataOp;
+    SmvConvolutionOp* convOp;
+};
+
+TEST_CASE_METHOD(SessionTest, "Run a session on many inputs", "[session]") {
+    buildConvNetwork();
+    Tensor* inputA = newInput("inputA");
+    Tensor* inputB = newInput("inputB");
+    int numSchedulerThreads = GENERATE(0, 2);
+    Session session(network(), workspace(), numSchedulerThreads);
+
+    session.setInput("data", inputA);
+    Tensor* outputA = copyOf(session.run(), "outputA");
+    TiledTensor* convTiles = convOp->getTiledInput(0);
+    REQUIRE(convTiles->size() > 1);
+    const Tensor* firstTile = (*convTiles)[0];
+
+    session.setInput("data", inputB);
+    Tensor* outputB = copyOf(session.run(), "outputB");
+    REQUIRE(!isSame(outputA, outputB));
+
+    session.setInput("data", inputA);
+    Tensor* output = session.run();
+    REQUIRE(isSame(output, outputA));
+    REQUIRE(session.getNumRuns() == 3);
+    // The operators were not tiled again.
+    REQUIRE(convOp->getTiledInput(0) == convTiles);
+    REQUIRE((*convTiles)[0] == firstTile);
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "smaug/core/tensor.h"
 #include "smaug/core/tensor_utils.h"
 #include "smaug/core/globals.h"
@@ -63,7 +65,9 @@ TensorProto* Tensor::asTensorProto() {
 }
 
 Tensor* TiledTensor::getTileWithData(int index) {
+    invalidateStaleTiles();
     Tile* tile = &tiles[index];
+    waitForPendingCopy(tile);
     copyDataToTile(tile);
     return tile->tensor;
 }
@@ -80,40 +84,112 @@ void TiledTensor::setTile(int index,
         copyDataToTile(tile);
 }
 
-void* TiledTensor::tileCopyWorker(void* _args) {
-    auto args = reinterpret_cast<CopyTilesArgs*>(_args);
-    TiledTensor* tiledTensor = args->tiledTensor;
-    int start = args->start;
-    int numTiles = args->numTiles;
-    TileDataOperation op = args->op;
-    for (int i = start; i < start + numTiles; i++) {
-        Tile* tile = tiledTensor->getTile(i);
-        if (op == Scatter)
-            tiledTensor->copyDataToTile(tile);
-        else if (op == Gather)
-            tiledTensor->gatherDataFromTile(tile);
+bool TiledTensor::setTileView(int index,
+                              const std::vector<int>& origin,
+                              Tensor* tensor) {
+    if (!useTileViews || !origTensor || !origTensor->containsData())
+        return false;
+    int offset = getContiguousOffset(origin, tensor->getShape());
+    if (offset < 0)
+        return false;
+    Tile* tile = &tiles[index];
+    tile->tensor = tensor;
+    tile->origin = origin;
+    tile->hasOrigin = true;
+    tile->isView = true;
+    tile->viewOffset = offset;
+    tensor->setDataType(origTensor->getDataType());
+    bindView(tile);
+    return true;
+}
+
+int TiledTensor::getContiguousOffset(const std::vector<int>& origin,
+                                     const TensorShape& tileShape) const {
+    const TensorShape& origShape = origTensor->getShape();
+    int ndims = origShape.ndims();
+    int alignment = std::max(origShape.getAlignment(), 1);
+    int offset;
+    if (useRawTensor) {
+        // Raw tiles are flat ranges of the original storage, but any padding
+        // at the end of one would overlap the next.
+        if (tileShape.getPadding(tileShape.ndims() - 1) != 0)
+            return -1;
+        offset = origin[0];
+    } else {
+        if (tileShape.ndims() != ndims)
+            return -1;
+        // Only the outermost dimension of the tile that is larger than one
+        // may be partial. All inner dimensions must be whole.
+        int partialDim = 0;
+        while (partialDim < ndims - 1 && tileShape[partialDim] == 1)
+            partialDim++;
+        for (int i = partialDim + 1; i < ndims; i++) {
+            if (tileShape[i] != origShape[i])
+                return -1;
+        }
+        // The tile's rows must be padded like the original's, unless the tile
+        // is a single partial row without any padding.
+        int last = ndims - 1;
+        if (tileShape.getStorageDim(last) != origShape.getStorageDim(last) &&
+            !(partialDim == last && tileShape.getPadding(last) == 0))
+            return -1;
+        offset = 0;
+        for (int i = 0; i < ndims; i++)
+            offset = offset * origShape.getStorageDim(i) + origin[i];
     }
-    delete args;
-    return nullptr;
+    // Keep the view as aligned as separately allocated tiles would be.
+    if (offset % alignment != 0 ||
+        offset + tileShape.storageSize() > origShape.storageSize())
+        return -1;
+    return offset;
+}
+
+bool TiledTensor::isViewOfOrigStorage(Tile* tile) const {
+    if (!origTensor->containsData() || !tile->tensor->containsData())
+        return false;
+    char* origData = reinterpret_cast<char*>(origTensor->getStorage().get());
+    return tile->tensor->getStorage().get() ==
+           origData + tile->viewOffset * origTensor->getDataTypeSize();
+}
+
+void TiledTensor::bindView(Tile* tile) {
+    assert(origTensor->containsData() &&
+           "The original Tensor of a tile view must have storage!");
+    std::shared_ptr<void> storage = origTensor->getStorage();
+    char* data = reinterpret_cast<char*>(storage.get()) +
+                 tile->viewOffset * origTensor->getDataTypeSize();
+    tile->tensor->freeStorage();
+    // The aliasing constructor shares the ownership of the original storage.
+    tile->tensor->setStorage(std::shared_ptr<void>(storage, data));
+}
+
+void TiledTensor::setPackedTile(int index, std::shared_ptr<void> storage) {
+    assert(isTileCopy(index) && "Only copies of the data can be packed!");
+    Tile* tile = &tiles[index];
+    invalidateStaleTiles();
+    waitForPendingCopy(tile);
+    tile->tensor->freeStorage();
+    tile->tensor->setStorage(storage);
+    tile->hasData = true;
 }
 
 void TiledTensor::parallelCopyTileData(TileDataOperation op) {
     int totalNumTiles = tiles.size();
     int numTilesPerThread = std::ceil(totalNumTiles * 1.0 / threadPool->size());
-    int remainingTiles = totalNumTiles;
-    while (remainingTiles > 0) {
-        int numTiles = std::min(numTilesPerThread, remainingTiles);
-        auto args = new CopyTilesArgs(
-                this, totalNumTiles - remainingTiles, numTiles, op);
-        int cpuid =
-                threadPool->dispatchThread(tileCopyWorker, (void*)args);
-        assert(cpuid != -1 && "Failed to dispatch thread!");
-        remainingTiles -= numTiles;
-    }
-    threadPool->joinThreadPool();
+    threadPool->parallelFor(
+            0, totalNumTiles, numTilesPerThread, [this, op](int start, int end) {
+                for (int i = start; i < end; i++) {
+                    Tile* tile = getTile(i);
+                    if (op == Scatter)
+                        copyDataToTile(tile);
+                    else if (op == Gather && !tile->gathered)
+                        gatherDataFromTile(tile);
+                }
+            });
 }
 
 void TiledTensor::copyDataToAllTiles() {
+    invalidateStaleTiles();
     // Don't copy if all the tiles have data filled.
     if (dataFilled)
         return;
@@ -129,12 +205,67 @@ void TiledTensor::copyDataToAllTiles() {
     dataFilled = true;
 }
 
+bool TiledTensor::isPipelined() const {
+    return pipelineTiles && threadPool && !fastForwardMode;
+}
+
+void TiledTensor::waitForPendingCopy(Tile* tile) {
+    if (tile->pendingCopy.valid()) {
+        threadPool->waitFor(tile->pendingCopy);
+        tile->pendingCopy = std::shared_future<void>();
+    }
+}
+
+void TiledTensor::invalidateStaleTiles() {
+    if (sharesProducerTiles || filledVersion == getOrigVersion())
+        return;
+    for (auto& tile : tiles) {
+        waitForPendingCopy(&tile);
+        tile.hasData = false;
+    }
+    dataFilled = false;
+    filledVersion = getOrigVersion();
+}
+
+void TiledTensor::prefetchAllTiles() {
+    invalidateStaleTiles();
+    if (dataFilled)
+        return;
+
+    if (!isPipelined() || tiles.size() == 1) {
+        copyDataToAllTiles();
+        return;
+    }
+    assert(origTensor != nullptr &&
+           "TiledTensor must have the original tensor to copy data from!");
+    // Queue the tiles in the order they are indexed, which is the order most
+    // operators consume them in.
+    for (auto index = startIndex(); !index.end(); ++index) {
+        Tile* tile = &tiles[index];
+        if (tile->hasData || tile->pendingCopy.valid())
+            continue;
+        tile->pendingCopy =
+                threadPool->submit([this, tile]() { copyDataToTile(tile); })
+                        .share();
+    }
+    dataFilled = true;
+}
+
 void TiledTensor::copyDataToTile(Tile* tile) {
     // Don't copy if the tile already has data,  or if the tile is the original
     // tensor (we have only one tile).
     if (tile->hasData || tile->tensor == origTensor)
         return;
 
+    if (tile->isView) {
+        // The view reads the original Tensor directly. It only needs to be
+        // pointed at the original's storage again if that was replaced.
+        if (!isViewOfOrigStorage(tile))
+            bindView(tile);
+        tile->hasData = true;
+        return;
+    }
+
     // Perform the data copy.
     assert(tile->hasOrigin &&
            "Must set the tile's origin in the original tensor!");
@@ -159,16 +290,42 @@ void TiledTensor::untile() {
         // No need to copy data if the tile is the original tensor.
         return;
     }
+    if (forwarded) {
+        // The consumer reads the tiles directly.
+        return;
+    }
 
+    // Finish the tiles that are already being gathered in the background.
+    for (auto& tile : tiles)
+        waitForPendingCopy(&tile);
     if (fastForwardMode || !threadPool) {
-        for (auto index = startIndex(); !index.end(); ++index)
-            gatherDataFromTile(&tiles[index]);
+        for (auto index = startIndex(); !index.end(); ++index) {
+            if (!tiles[index].gathered)
+                gatherDataFromTile(&tiles[index]);
+        }
     } else {
         parallelCopyTileData(Gather);
     }
+    for (auto& tile : tiles)
+        tile.gathered = false;
+}
+
+void TiledTensor::gatherTileAsync(int index) {
+    if (!isPipelined() || tiles.size() == 1 || forwarded)
+        return;
+    Tile* tile = &tiles[index];
+    waitForPendingCopy(tile);
+    tile->gathered = true;
+    tile->pendingCopy =
+            threadPool->submit([this, tile]() { gatherDataFromTile(tile); })
+                    .share();
 }
 
 void TiledTensor::gatherDataFromTile(Tile* tile) {
+    // The data of a view was written in place.
+    if (tile->isView && isViewOfOrigStorage(tile))
+        return;
+
     // Perform the data copy.
     assert(tile->hasOrigin &&
            "Must set the tile's origin in the original tensor!");
@@ -186,4 +343,41 @@ void TiledTensor::gatherDataFromTile(Tile* tile) {
     }
 }
 
+bool TiledTensor::hasSameTiling(const TiledTensor& other) const {
+    if (origTensor == nullptr || origTensor != other.origTensor ||
+        shape.dims() != other.shape.dims() ||
+        useRawTensor != other.useRawTensor)
+        return false;
+    for (int i = 0; i < tiles.size(); i++) {
+        const Tile& tile = tiles[i];
+        const Tile& otherTile = other.tiles[i];
+        if (!tile.hasOrigin || !otherTile.hasOrigin ||
+            tile.origin != otherTile.origin)
+            return false;
+        const TensorShape& tileShape = tile.tensor->getShape();
+        const TensorShape& otherTileShape = otherTile.tensor->getShape();
+        if (!(tileShape == otherTileShape) ||
+            tileShape.getAlignment() != otherTileShape.getAlignment() ||
+            tile.tensor->getDataType() != otherTile.tensor->getDataType())
+            return false;
+    }
+    return true;
+}
+
+void TiledTensor::forwardTilesTo(TiledTensor& consumer) {
+    assert(hasSameTiling(consumer) &&
+           "Tiles can only be forwarded between identical tilings!");
+    for (int i = 0; i < tiles.size(); i++) {
+        Tile& consumerTile = consumer.tiles[i];
+        consumerTile.tensor = tiles[i].tensor;
+        consumerTile.isView = tiles[i].isView;
+        consumerTile.viewOffset = tiles[i].viewOffset;
+        // The producer fills the tile before the consumer runs.
+        consumerTile.hasData = true;
+    }
+    consumer.dataFilled = true;
+    consumer.sharesProducerTiles = true;
+    forwarded = true;
+}
+
 }  // namespace smaug
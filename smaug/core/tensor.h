@@ -1,9 +1,12 @@
 #ifndef _CORE_TENSOR_H_
 #define _CORE_TENSOR_H_
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <cmath>
+#include <future>
 #include <initializer_list>
 #include <iostream>
 #include <memory>
@@ -11,6 +14,7 @@
 
 #include <google/protobuf/repeated_field.h>
 
+#include "smaug/core/allocator.h"
 #include "smaug/core/datatypes.h"
 #include "smaug/core/tensor.pb.h"
 #include "smaug/utility/utils.h"
@@ -124,35 +128,66 @@ class TensorShape {
  *   data[iter(3,4,0,0)] = 3.4;
  *
  * The iterator skips over data alignment padding areas, if any exist.
+ *
+ * The stride of each dimension is computed once, and the linear index is
+ * updated incrementally as the iterator advances, so iterating never has to
+ * recompute it from the coordinates. Coordinates are kept in fixed-size
+ * arrays, so iterators never allocate; Tensors of up to kMaxRank dimensions
+ * are supported.
  */
 class TensorIndexIterator {
    public:
+    /** The highest rank of a Tensor that can be iterated over. */
+    static constexpr int kMaxRank = 5;
+
     TensorIndexIterator(const TensorShape& shape, bool _atEnd = false)
-            : dims(shape.dims()), padding(shape.padding()), atEnd(_atEnd),
-              advanceOne(std::vector<int>(dims.size(), 1)) {
-        state.resize(dims.size(), 0);
+            : rank(shape.ndims()), offset(0), atEnd(_atEnd) {
+        assert(rank <= kMaxRank && "Tensor rank is too high to iterate over!");
+        int stride = 1;
+        for (int i = rank - 1; i >= 0; i--) {
+            state[i] = 0;
+            dims[i] = shape[i];
+            lower[i] = 0;
+            upper[i] = dims[i];
+            strides[i] = stride;
+            stride *= shape.getStorageDim(i);
+        }
     }
 
-    operator int() const { return getIndex(state); }
+    operator int() const { return offset; }
 
     bool end() const { return atEnd; }
 
-    void operator++() { advanceRegion(advanceOne); }
+    void operator++() {
+        // Fast path: stay within the innermost dimension.
+        if (rank > 0 && state[rank - 1] + 1 < upper[rank - 1]) {
+            state[rank - 1]++;
+            offset++;
+            return;
+        }
+        advanceOne();
+    }
 
     void operator+=(const std::vector<int>& region) {
-        assert(region.size() == state.size());
-        advanceRegion(region);
+        assert(region.size() == rank);
+        advanceRegion(region.data());
     }
 
     template <typename... Args>
-    int operator()(int i, Args... args) {
-        auto indices = variadicToArray(i, args...);
-        return getIndex(indices);
+    int operator()(int i, Args... args) const {
+        assert(sizeof...(Args) + 1 == rank);
+        return getIndex(variadicToArray(i, args...));
     }
 
     bool operator==(const TensorIndexIterator& other) const {
-        return (state == other.state && dims == other.dims &&
-                padding == other.padding && atEnd == other.atEnd);
+        if (rank != other.rank || atEnd != other.atEnd)
+            return false;
+        for (int i = 0; i < rank; i++) {
+            if (state[i] != other.state[i] || dims[i] != other.dims[i] ||
+                strides[i] != other.strides[i])
+                return false;
+        }
+        return true;
     }
 
     bool operator!=(const TensorIndexIterator& other) const {
@@ -168,48 +203,103 @@ class TensorIndexIterator {
    protected:
     /**
      * Returns the linear index into the Tensor's underlying data container at
-     * the specified coordinates.
+     * the specified coordinates. The number of coordinates is known at compile
+     * time, so the loop is fully unrolled.
      */
-    template <typename Container>
-    int getIndex(Container indices) const {
-        int linearIndex = 0, stride = 1;
-        for (int i = (int)indices.size() - 1; i >= 0; i--) {
-            linearIndex += indices[i] * stride;
-            stride *= (dims.at(i) + padding.at(i));
-        }
+    template <size_t N>
+    int getIndex(const std::array<int, N>& indices) const {
+        int linearIndex = 0;
+        for (int i = 0; i < (int)N; i++)
+            linearIndex += indices[i] * strides[i];
         return linearIndex;
     }
 
-    /*
+    /**
      * Advance the current iterator position by the given region size.
      *
-     * @param region An N-dim vector indicating how far to increment in each
+     * @param region An N-dim array indicating how far to increment in each
      * dimension, if the previous dimension overflowed and caused a carry-over
      * into the next dimension.
      */
-    virtual void advanceRegion(const std::vector<int>& region) {
-        bool carry = true;
-        for (int i = (int)state.size() - 1; i >= 0 && carry; i--) {
-            int currValue = state[i] + region[i];
-            carry = (currValue >= dims[i]);
-            if (carry)
-                currValue = 0;
-            state[i] = currValue;
+    void advanceRegion(const int* region) {
+        switch (rank) {
+            case 2:
+                advanceFixedRank<2>(region);
+                break;
+            case 3:
+                advanceFixedRank<3>(region);
+                break;
+            case 4:
+                advanceFixedRank<4>(region);
+                break;
+            case 5:
+                advanceFixedRank<5>(region);
+                break;
+            default:
+                advanceRegionAnyRank(region);
+        }
+    }
+
+    /** advanceRegion unrolled for a fixed rank. */
+    template <int Rank>
+    void advanceFixedRank(const int* region) {
+        for (int i = Rank - 1; i >= 0; i--) {
+            if (advanceDim(i, region[i]))
+                return;
+        }
+        atEnd = true;
+    }
+
+    void advanceRegionAnyRank(const int* region) {
+        for (int i = rank - 1; i >= 0; i--) {
+            if (advanceDim(i, region[i]))
+                return;
+        }
+        atEnd = true;
+    }
+
+    /** Carry an increment of one out of the innermost dimension. */
+    void advanceOne() {
+        static const int kOnes[kMaxRank] = { 1, 1, 1, 1, 1 };
+        advanceRegion(kOnes);
+    }
+
+    /**
+     * Moves along one dimension, updating the linear offset incrementally.
+     * Returns false if the dimension wrapped around and carries into the
+     * next outer one.
+     */
+    bool advanceDim(int dim, int step) {
+        int value = state[dim] + step;
+        if (value < upper[dim]) {
+            state[dim] = value;
+            offset += step * strides[dim];
+            return true;
         }
-        if (carry)
-            atEnd = true;
+        offset -= (state[dim] - lower[dim]) * strides[dim];
+        state[dim] = lower[dim];
+        return false;
     }
 
+    /** Number of dimensions of this iterator's Tensor. */
+    int rank;
     /** The current location of the iterator. */
-    std::vector<int> state;
+    std::array<int, kMaxRank> state;
     /** The dimensions of this iterator's Tensor. */
-    std::vector<int> dims;
-    /** Alignment padding of the Tensor. */
-    std::vector<int> padding;
+    std::array<int, kMaxRank> dims;
+    /**
+     * The linear distance between consecutive elements of each dimension,
+     * including alignment padding.
+     */
+    std::array<int, kMaxRank> strides;
+    /** The first index visited on each dimension. */
+    std::array<int, kMaxRank> lower;
+    /** One past the last index visited on each dimension. */
+    std::array<int, kMaxRank> upper;
+    /** The linear index of the current location. */
+    int offset;
     /** If true, we've reached the end of the Tensor. */
     bool atEnd;
-    /** A vector of all ones, used to implement operator++. */
-    const std::vector<int> advanceOne;
 };
 
 /**
@@ -231,31 +321,17 @@ class TensorIndexIterator {
 class TensorRegionIndexIterator : public TensorIndexIterator {
    public:
     TensorRegionIndexIterator(const TensorShape& shape,
-                              const std::vector<int>& _origin,
-                              const std::vector<int>& _regionSize)
-            : TensorIndexIterator(shape, false), origin(_origin),
-              regionSize(_regionSize) {
-        state = origin;
-    }
-
-   protected:
-    /** Advance the tensor region index with the specified region size. */
-    virtual void advanceRegion(const std::vector<int>& advanceRegionSize) {
-        bool carry = true;
-        for (int i = (int)state.size() - 1; i >= 0 && carry; i--) {
-            int currValue = state[i] + advanceRegionSize[i];
-            carry = (currValue >= dims[i] ||
-                     currValue >= origin[i] + regionSize[i]);
-            if (carry)
-                currValue = origin[i];
-            state[i] = currValue;
+                              const std::vector<int>& origin,
+                              const std::vector<int>& regionSize)
+            : TensorIndexIterator(shape, false) {
+        assert(origin.size() == rank && regionSize.size() == rank);
+        for (int i = 0; i < rank; i++) {
+            state[i] = origin[i];
+            lower[i] = origin[i];
+            upper[i] = std::min(dims[i], origin[i] + regionSize[i]);
+            offset += origin[i] * strides[i];
         }
-        if (carry)
-            atEnd = true;
     }
-
-    std::vector<int> origin;
-    std::vector<int> regionSize;
 };
 
 /**
@@ -289,6 +365,11 @@ class TensorBase {
     int getTotalDim(int index) const { return shape.getStorageDim(index); }
     int getDataStorageFormat() const { return dataFormat; }
     DataType getDataType() const { return dataType; }
+    /**
+     * Sets the data type of a Tensor whose storage will be provided later,
+     * like by the MemoryPlanner or the Scheduler.
+     */
+    void setDataType(DataType _dataType) { dataType = _dataType; }
     int getDataTypeSize() const {
         switch (dataType) {
             case Float16:
@@ -343,11 +424,13 @@ class TensorBase {
  */
 class Tensor : public TensorBase {
    public:
-    Tensor() : TensorBase(), tensorData(NULL) {}
+    Tensor()
+            : TensorBase(), tensorData(NULL), allocator(nullptr), version(0) {}
 
     /** Construct a Tensor with the given name and shape. */
     Tensor(const std::string& _name, const TensorShape& _shape)
-            : TensorBase(_name, _shape), tensorData(NULL) {}
+            : TensorBase(_name, _shape), tensorData(NULL), allocator(nullptr),
+              version(0) {}
     virtual ~Tensor() {}
 
     /**
@@ -355,34 +438,25 @@ class Tensor : public TensorBase {
      *
      * @param tensorProto Basic parameters of the Tensor.
      * @param tensorData The data contents of the Tensor.
+     * @param _allocator The allocator of the Tensor's storage, if not the heap.
      */
-    Tensor(const TensorProto& tensorProto, const TensorData& tensorData)
-            : TensorBase(tensorProto), tensorData(NULL) {
-        DataType dataType = tensorProto.data_type();
-        switch (dataType) {
-            case Float16:
-                fillHalfData(tensorData.half_data());
-                break;
-            case Float32:
-                fillData<float>(tensorData.float_data());
-                break;
-            case Float64:
-                fillData<double>(tensorData.double_data());
-                break;
-            case Int32:
-                fillData<int>(tensorData.int_data());
-                break;
-            case Int64:
-                fillData<int64_t>(tensorData.int64_data());
-                break;
-            case Bool:
-                fillData<bool>(tensorData.bool_data());
-                break;
-            default:
-                assert(false && "Unknown data format!");
-        }
+    Tensor(const TensorProto& tensorProto,
+           const TensorData& tensorData,
+           Allocator* _allocator = nullptr)
+            : TensorBase(tensorProto), tensorData(NULL), allocator(_allocator),
+              version(0) {
+        fillData(tensorData);
     }
 
+    /**
+     * Constructs a Tensor from a serialized TensorProto, without any data.
+     * Its contents can be filled later with fillData(const TensorData&).
+     */
+    explicit Tensor(const TensorProto& tensorProto,
+                    Allocator* _allocator = nullptr)
+            : TensorBase(tensorProto), tensorData(NULL), allocator(_allocator),
+              version(0) {}
+
     /** Returns an iterator starting at the beginning of the Tensor. */
     TensorIndexIterator startIndex() const {
         return TensorIndexIterator(shape);
@@ -390,6 +464,19 @@ class Tensor : public TensorBase {
 
     virtual bool containsData() const { return tensorData != nullptr; }
 
+    /**
+     * Returns the number of times the contents of the Tensor have been
+     * replaced, as reported by markUpdated().
+     */
+    int getVersion() const { return version; }
+
+    /**
+     * Records that the contents of the Tensor have been rewritten, like by
+     * the Operator producing it, so any copies of the old data (like tiles)
+     * are stale.
+     */
+    void markUpdated() { version++; }
+
     /**
      * Fills the Tensor with externalData.
      *
@@ -443,6 +530,36 @@ class Tensor : public TensorBase {
 #endif
     }
 
+    /**
+     * Fills the Tensor with the contents of a serialized TensorData, which
+     * must match the Tensor's data type. Storage is allocated first if the
+     * Tensor has none.
+     */
+    void fillData(const TensorData& tensorData) {
+        switch (dataType) {
+            case Float16:
+                fillHalfData(tensorData.half_data());
+                break;
+            case Float32:
+                fillData<float>(tensorData.float_data());
+                break;
+            case Float64:
+                fillData<double>(tensorData.double_data());
+                break;
+            case Int32:
+                fillData<int>(tensorData.int_data());
+                break;
+            case Int64:
+                fillData<int64_t>(tensorData.int64_data());
+                break;
+            case Bool:
+                fillData<bool>(tensorData.bool_data());
+                break;
+            default:
+                assert(false && "Unknown data format!");
+        }
+    }
+
     /**
      * Fill the tensor with float16 data.
      *
@@ -464,6 +581,35 @@ class Tensor : public TensorBase {
 #endif
     }
 
+    /**
+     * Makes the Tensor use the given storage, like a region of a larger
+     * memory arena, instead of allocating its own. The data type must already
+     * be set and the storage must hold at least storageSize() elements.
+     */
+    void setStorage(std::shared_ptr<void> storage) {
+        assert(tensorData == NULL && "The Tensor already has storage!");
+        assert(dataType != UnknownDataType &&
+               "The data type must be set before the storage!");
+        tensorData = storage;
+    }
+
+    /**
+     * Releases the Tensor's storage. The data type is kept, so that storage
+     * can be allocated again later.
+     */
+    void freeStorage() { tensorData.reset(); }
+
+    /** Returns the storage of this Tensor, which may be shared with others. */
+    std::shared_ptr<void> getStorage() const { return tensorData; }
+
+    /**
+     * Sets the allocator that allocateStorage() gets storage from. By
+     * default, or if this is null, every Tensor's storage is a separate heap
+     * allocation.
+     */
+    void setAllocator(Allocator* _allocator) { allocator = _allocator; }
+    Allocator* getAllocator() const { return allocator; }
+
     /**
      * Allocates memory to store Tensor data.
      *
@@ -475,8 +621,12 @@ class Tensor : public TensorBase {
             dataType = ToDataType<T>::dataType;
             int size = shape.storageSize();
             assert(size > 0 && "Attempted to allocate zero storage!");
-            tensorData = std::shared_ptr<void>(
-                    malloc_aligned(size * sizeof(T), false), free);
+            if (allocator) {
+                tensorData = allocator->allocate(size * sizeof(T));
+            } else {
+                tensorData = std::shared_ptr<void>(
+                        malloc_aligned(size * sizeof(T), false), free);
+            }
         }
         return reinterpret_cast<T*>(tensorData.get());
     }
@@ -539,6 +689,10 @@ class Tensor : public TensorBase {
 
    protected:
     std::shared_ptr<void> tensorData;
+    /** See setAllocator(). */
+    Allocator* allocator;
+    /** See getVersion(). */
+    int version;
 };
 
 /**
@@ -553,7 +707,8 @@ class TiledTensor : public TensorBase {
   public:
    TiledTensor(Tensor* _origTensor = nullptr, bool _useRawTensor = false)
            : TensorBase(), origTensor(_origTensor), useRawTensor(_useRawTensor),
-             dataFilled(false) {}
+             dataFilled(false), filledVersion(getOrigVersion()),
+             forwarded(false), sharesProducerTiles(false) {}
    /**
     * Construct a TiledTensor.
     *
@@ -568,7 +723,9 @@ class TiledTensor : public TensorBase {
                Tensor* _origTensor = nullptr,
                bool _useRawTensor = false)
            : TensorBase("", shape), origTensor(_origTensor),
-             useRawTensor(_useRawTensor), dataFilled(false) {
+             useRawTensor(_useRawTensor), dataFilled(false),
+             filledVersion(getOrigVersion()), forwarded(false),
+             sharesProducerTiles(false) {
        tiles.resize(shape.size());
    }
 
@@ -612,16 +769,91 @@ class TiledTensor : public TensorBase {
                 Tensor* tensor,
                 bool copyData);
 
+   /**
+    * Set the specified tile to a view into the original Tensor's storage,
+    * instead of a separate copy of its data, if the tile's region occupies
+    * one contiguous range of that storage. This is the case when tiling
+    * along the outermost dimension only, e.g. by batch, or by rows when the
+    * batch size is one. Views need no data copied in or out, and no storage
+    * of their own.
+    *
+    * @param tensor The tile Tensor, without any storage.
+    * @returns False if the tile cannot be a view, in which case nothing is
+    * set. The caller should then allocate the tile and call setTile().
+    */
+   bool setTileView(int index, const std::vector<int>& origin, Tensor* tensor);
+
    /** Copies data (if needed) to all the tiles from the original Tensor. */
    void copyDataToAllTiles();
 
+   /**
+    * Starts copying data to all the tiles in the background, so that the
+    * operator can start working on the first tiles while the later ones are
+    * still being filled. getTileWithData() waits only for the tile it returns.
+    *
+    * This is the same as copyDataToAllTiles() unless tile pipelining is
+    * enabled and there is a thread pool.
+    */
+   void prefetchAllTiles();
+
+   /**
+    * Starts copying the data of the given tile back to the original Tensor in
+    * the background. This must only be called once the tile's data is final.
+    * untile() waits for these copies and skips the tiles already gathered.
+    *
+    * If tile pipelining is disabled, this does nothing and the tile is
+    * gathered by untile() as usual.
+    */
+   void gatherTileAsync(int index);
+
    /**
     * Copies data from the TiledTensor into the original Tensor. We name it
     * "untile" because what it does reverses the tiling process.
     */
    void untile();
 
-   static void* tileCopyWorker(void* _args);
+   /**
+    * Returns true if both TiledTensors tile the same Tensor into the same
+    * grid of tiles, where every tile has the same origin and shape.
+    */
+   bool hasSameTiling(const TiledTensor& other) const;
+
+   /**
+    * Hands the tiles of this TiledTensor, which holds a producer's output,
+    * directly to the consumer's TiledTensor for the same Tensor. This must
+    * have the same tiling as the consumer.
+    *
+    * The consumer then works on the producer's output tiles in place, without
+    * copying them in from the original Tensor, and untile() becomes a no-op
+    * on this TiledTensor. The original Tensor is therefore never filled, so
+    * this is only valid if the consumer is its only reader.
+    */
+   void forwardTilesTo(TiledTensor& consumer);
+
+   /** Returns true if this TiledTensor's tiles are forwarded to a consumer. */
+   bool isForwarded() const { return forwarded; }
+
+   /** Returns the origin of the tile in the original Tensor. */
+   const std::vector<int>& getTileOrigin(int index) const {
+       return tiles.at(index).origin;
+   }
+
+   /**
+    * Returns true if the tile holds a copy of its region of the original
+    * Tensor, rather than being a view into it or the original itself.
+    */
+   bool isTileCopy(int index) const {
+       const Tile& tile = tiles.at(index);
+       return tile.tensor && tile.tensor != origTensor && !tile.isView;
+   }
+
+   /**
+    * Makes the tile use the given storage, which already holds its data,
+    * like a packed weight tile from a parameters file (see packWeights()).
+    * The tile is not filled from the original Tensor again, unless that is
+    * updated.
+    */
+   void setPackedTile(int index, std::shared_ptr<void> storage);
 
   protected:
    /**
@@ -636,13 +868,23 @@ class TiledTensor : public TensorBase {
        bool hasOrigin;
        /** True if we have copied data to this tile. */
        bool hasData;
+       /** True if this tile's data has been copied back to the original. */
+       bool gathered;
+       /** An in-flight background copy into or out of this tile, if any. */
+       std::shared_future<void> pendingCopy;
+       /** True if the tile is a view into the original Tensor's storage. */
+       bool isView;
+       /** The element offset of a view in the original Tensor's storage. */
+       int viewOffset;
 
        /**
         * Construct a new blank Tile.
         *
         * Set the properties of this Tile using TiledTensor::setTile
         */
-       Tile() : tensor(nullptr), origin(), hasOrigin(false), hasData(false) {}
+       Tile()
+               : tensor(nullptr), origin(), hasOrigin(false), hasData(false),
+                 gathered(false), isView(false), viewOffset(0) {}
    };
 
    /**
@@ -655,20 +897,6 @@ class TiledTensor : public TensorBase {
      Gather
    };
 
-   struct CopyTilesArgs {
-       TiledTensor* tiledTensor;
-       int start;
-       int numTiles;
-       TileDataOperation op;
-
-       CopyTilesArgs(TiledTensor* _tiledTensor,
-                     int _start,
-                     int _numTiles,
-                     TileDataOperation _op)
-               : tiledTensor(_tiledTensor), start(_start), numTiles(_numTiles),
-                 op(_op) {}
-   };
-
    Tile* getTile(int index) { return &tiles[index]; }
 
    /** Copy data (if needed) to this tile from the original Tensor. */
@@ -677,9 +905,40 @@ class TiledTensor : public TensorBase {
    /** Copy data from this tile to the original Tensor. */
    void gatherDataFromTile(Tile* tile);
 
+   /**
+    * Returns the element offset of a tile of the given shape and origin in
+    * the original Tensor's storage, or -1 if the tile does not occupy one
+    * contiguous, aligned range of it.
+    */
+   int getContiguousOffset(const std::vector<int>& origin,
+                           const TensorShape& tileShape) const;
+
+   /** Returns true if the view still points into the original's storage. */
+   bool isViewOfOrigStorage(Tile* tile) const;
+
+   /** Points the view's Tensor at its region of the original's storage. */
+   void bindView(Tile* tile);
+
    /** Split the work (data filling or gathering) across multiple threads. */
    void parallelCopyTileData(TileDataOperation op);
 
+   /** Waits for the tile's in-flight background copy, if there is one. */
+   void waitForPendingCopy(Tile* tile);
+
+   /** Returns true if tile copies should be pipelined on the thread pool. */
+   bool isPipelined() const;
+
+   /** Returns the version of the original Tensor, if there is one. */
+   int getOrigVersion() const {
+       return origTensor ? origTensor->getVersion() : 0;
+   }
+
+   /**
+    * Marks all the tiles as empty if the original Tensor has been updated
+    * since they were filled, so the next access copies the new data in.
+    */
+   void invalidateStaleTiles();
+
    /** True if we should use copyRawTensorData() for copying data. */
    bool useRawTensor;
 
@@ -689,6 +948,18 @@ class TiledTensor : public TensorBase {
    /** True if all the tiles have data filled. */
    bool dataFilled;
 
+   /** The version of origTensor that the tiles were filled from. */
+   int filledVersion;
+
+   /** True if the tiles are read directly by the consumer of origTensor. */
+   bool forwarded;
+
+   /**
+    * True if the tiles were forwarded to this TiledTensor by the producer of
+    * origTensor, which fills them every time it runs.
+    */
+   bool sharesProducerTiles;
+
    /** The list of Tiles, indexed using a TensorIndexIterator. */
    std::vector<Tile> tiles;
 };
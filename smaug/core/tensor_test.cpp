@@ -1,8 +1,12 @@
 #include "catch.hpp"
 #include "smaug/core/backend.h"
 #include "smaug/core/tensor.h"
+#include "smaug/core/globals.h"
 #include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor_utils.h"
+#include "smaug/utility/thread_pool.h"
 #include "smaug/operators/data_op.h"
+#include "smaug/operators/relu_op.h"
 
 using namespace smaug;
 
@@ -52,3 +56,192 @@ TEST_CASE_METHOD(SmaugTest, "Unpacking of float16 tensor data", "[fp16]") {
     }
 }
 
+
+TEST_CASE_METHOD(SmaugTest, "Tiles as views of the tiled tensor", "[tiling]") {
+    // The operator only names the tiles.
+    auto reluOp = new ReluOp<ReferenceBackend>("relu", workspace());
+    network()->addOperator(reluOp);
+    TensorShape shape({ 4, 8, 8, 16 }, DataLayout::NHWC);
+    Tensor* tensor = new Tensor("tensor", shape);
+    float* data = tensor->allocateStorage<float>();
+    for (int i = 0; i < shape.storageSize(); i++)
+        data[i] = i;
+    workspace()->addTensor(tensor);
+    const int kBatchSize = 8 * 8 * 16;
+
+    SECTION("Batch tiles are views") {
+        TiledTensor tiledTensor = generateTiledTensor(
+                tensor, TensorShape({ 1, 8, 8, 16 }, DataLayout::NHWC),
+                reluOp);
+        REQUIRE(tiledTensor.size() == 4);
+        for (int i = 0; i < tiledTensor.size(); i++) {
+            Tensor* tile = tiledTensor.getTileWithData(i);
+            REQUIRE(tile->data<float>() == data + i * kBatchSize);
+        }
+        // Writes to a tile go straight to the tiled tensor.
+        tiledTensor[1]->data<float>()[0] = -1;
+        tiledTensor.untile();
+        REQUIRE(data[kBatchSize] == -1);
+    }
+
+    SECTION("Channel tiles are copies") {
+        TiledTensor tiledTensor = generateTiledTensor(
+                tensor, TensorShape({ 1, 8, 8, 8 }, DataLayout::NHWC), reluOp);
+        REQUIRE(tiledTensor.size() == 8);
+        Tensor* tile = tiledTensor.getTileWithData(1);
+        const float* tileData = tile->data<float>();
+        REQUIRE((tileData < data || tileData >= data + shape.storageSize()));
+        // The second tile holds the second half of the channels.
+        REQUIRE(tileData[0] == 8);
+        REQUIRE(tileData[8] == 24);
+    }
+
+    SECTION("Views can be disabled") {
+        useTileViews = false;
+        TiledTensor tiledTensor = generateTiledTensor(
+                tensor, TensorShape({ 1, 8, 8, 16 }, DataLayout::NHWC),
+                reluOp);
+        useTileViews = true;
+        Tensor* tile = tiledTensor.getTileWithData(1);
+        REQUIRE(tile->data<float>() != data + kBatchSize);
+        REQUIRE(tile->data<float>()[0] == kBatchSize);
+    }
+}
+
+TEST_CASE_METHOD(SmaugTest, "Tensor index iterators", "[tensor]") {
+    // The innermost dimension (5) is padded to 8.
+    TensorShape shape({ 2, 3, 4, 5 }, DataLayout::NCHW, 8);
+
+    SECTION("Iterate over a padded tensor") {
+        auto it = TensorIndexIterator(shape);
+        for (int n = 0; n < 2; n++) {
+            for (int c = 0; c < 3; c++) {
+                for (int h = 0; h < 4; h++) {
+                    for (int w = 0; w < 5; w++) {
+                        REQUIRE(!it.end());
+                        int expected = ((n * 3 + c) * 4 + h) * 8 + w;
+                        REQUIRE(it == expected);
+                        REQUIRE(it(n, c, h, w) == expected);
+                        ++it;
+                    }
+                }
+            }
+        }
+        REQUIRE(it.end());
+    }
+
+    SECTION("Iterate over a region") {
+        auto it = TensorRegionIndexIterator(
+                shape, { 1, 1, 2, 1 }, { 1, 2, 2, 3 });
+        for (int c = 1; c < 3; c++) {
+            for (int h = 2; h < 4; h++) {
+                for (int w = 1; w < 4; w++) {
+                    REQUIRE(!it.end());
+                    REQUIRE(it == ((3 + c) * 4 + h) * 8 + w);
+                    REQUIRE(it.currentIndex(1) == c);
+                    ++it;
+                }
+            }
+        }
+        REQUIRE(it.end());
+    }
+
+    SECTION("Advance a region by whole rows") {
+        auto it = TensorRegionIndexIterator(
+                shape, { 0, 1, 0, 0 }, { 2, 1, 4, 5 });
+        std::vector<int> expected;
+        for (int n = 0; n < 2; n++) {
+            for (int h = 0; h < 4; h++)
+                expected.push_back(((n * 3 + 1) * 4 + h) * 8);
+        }
+        std::vector<int> indices;
+        for (; !it.end(); it += { 1, 1, 1, 5 })
+            indices.push_back(it);
+        REQUIRE(indices == expected);
+    }
+
+    SECTION("Iterate over tensors of other ranks") {
+        for (int ndims = 1; ndims <= TensorIndexIterator::kMaxRank; ndims++) {
+            TensorShape otherShape(
+                    std::vector<int>(ndims, 3), DataLayout::X, 0);
+            int count = 0;
+            for (auto it = TensorIndexIterator(otherShape); !it.end(); ++it)
+                REQUIRE(it == count++);
+            REQUIRE(count == otherShape.size());
+        }
+    }
+}
+
+class TensorCopyTest : public SmaugTest {
+   public:
+    ~TensorCopyTest() {
+        delete threadPool;
+        threadPool = nullptr;
+        fastForwardMode = true;
+    }
+
+    Tensor* newTensor(const std::string& name, const TensorShape& shape) {
+        Tensor* tensor = new Tensor(name, shape);
+        tensor->allocateStorage<float>();
+        workspace()->addTensor(tensor);
+        float* data = tensor->data<float>();
+        int i = 0;
+        for (auto idx = tensor->startIndex(); !idx.end(); ++idx)
+            data[idx] = i++;
+        return tensor;
+    }
+
+    /** Copies the region and checks it against an element-wise copy. */
+    void copyAndVerify(Tensor* dest,
+                       Tensor* src,
+                       const std::vector<int>& destOrigin,
+                       const std::vector<int>& srcOrigin,
+                       const std::vector<int>& regionSize) {
+        std::vector<float> expected(dest->getShape().storageSize());
+        float* destData = dest->data<float>();
+        float* srcData = src->data<float>();
+        std::copy(destData, destData + expected.size(), expected.begin());
+        auto destIt = TensorRegionIndexIterator(
+                dest->getShape(), destOrigin, regionSize);
+        auto srcIt = TensorRegionIndexIterator(
+                src->getShape(), srcOrigin, regionSize);
+        for (; !srcIt.end(); ++srcIt, ++destIt)
+            expected[destIt] = srcData[srcIt];
+
+        copyTensorRegion(dest, src, destOrigin, srcOrigin, regionSize);
+        for (auto idx = dest->startIndex(); !idx.end(); ++idx)
+            REQUIRE(destData[idx] == expected[idx]);
+    }
+};
+
+TEST_CASE_METHOD(TensorCopyTest, "Copy tensor regions", "[tensor]") {
+    SECTION("Rows are merged within padded tensors") {
+        TensorShape shape({ 4, 6, 10 }, DataLayout::NCT, 8);
+        Tensor* src = newTensor("src", shape);
+        Tensor* dest = newTensor("dest", shape);
+        copyAndVerify(dest, src, { 2, 0, 0 }, { 1, 0, 0 }, { 2, 6, 10 });
+        copyAndVerify(dest, src, { 0, 1, 0 }, { 3, 2, 0 }, { 1, 3, 10 });
+    }
+
+    SECTION("Tensors with different padding") {
+        Tensor* src = newTensor("src", TensorShape({ 3, 5, 7 }, NCT, 0));
+        Tensor* dest = newTensor("dest", TensorShape({ 3, 5, 7 }, NCT, 8));
+        copyAndVerify(dest, src, { 0, 0, 0 }, { 0, 0, 0 }, { 3, 5, 7 });
+        copyAndVerify(src, dest, { 1, 1, 2 }, { 0, 2, 1 }, { 2, 3, 4 });
+    }
+
+    SECTION("Large copies on a thread pool") {
+        threadPool = new ThreadPool(2, ThreadPool::Block);
+        threadPool->initThreadPool();
+        fastForwardMode = false;
+        TensorShape shape({ 4, 64, 64, 128 }, DataLayout::NHWC, 8);
+        Tensor* src = newTensor("src", shape);
+        Tensor* dest = newTensor("dest", shape);
+        // A single contiguous run.
+        copyAndVerify(
+                dest, src, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, { 4, 64, 64, 128 });
+        // Many short runs.
+        copyAndVerify(
+                dest, src, { 1, 2, 3, 4 }, { 0, 0, 0, 0 }, { 3, 60, 60, 100 });
+    }
+}
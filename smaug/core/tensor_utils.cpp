@@ -1,10 +1,18 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "fp16.h"
+#include "smaug/core/globals.h"
 #include "smaug/core/tensor.h"
 #include "smaug/core/tensor_utils.h"
 #include "smaug/core/workspace.h"
 #include "smaug/utility/debug_stream.h"
+#include "smaug/utility/thread_pool.h"
 
 namespace smaug {
 
@@ -28,7 +36,7 @@ std::ostream& operator<<(std::ostream& os, const TensorShape& shape) {
 
 std::ostream& operator<<(std::ostream& os, const TensorIndexIterator& iter) {
     os << "( ";
-    for (int i = 0; i < iter.dims.size(); ++i) {
+    for (int i = 0; i < iter.rank; ++i) {
         os << iter.state[i] << " ";
     }
     os << ")";
@@ -62,6 +70,219 @@ std::ostream& operator<<(std::ostream& os, const Tensor& tensor) {
     return os;
 }
 
+namespace internal {
+
+namespace {
+
+/** Copies of at least this many bytes are split across the thread pool. */
+const size_t kParallelCopyBytes = 1 << 20;
+/**
+ * Copies of at least this many bytes would evict most of the cache before
+ * they finish, so they write their destination with streaming stores.
+ */
+const size_t kStreamingCopyBytes = 8 << 20;
+
+/**
+ * The contiguous runs that a region copy breaks down into. The runs are
+ * visited by a loop nest, given from the outermost loop in.
+ */
+struct RegionCopyPlan {
+    size_t srcOffset;
+    size_t destOffset;
+    size_t runBytes;
+    std::vector<int> counts;
+    std::vector<size_t> srcStrides;
+    std::vector<size_t> destStrides;
+    int numRuns;
+};
+
+/**
+ * Builds the plan for a region copy. Rows that continue each other in both
+ * tensors are merged into a single run, and the loops over the runs are
+ * collapsed wherever the strides line up.
+ */
+RegionCopyPlan planRegionCopy(Tensor* dest,
+                              Tensor* src,
+                              const std::vector<int>& destOrigin,
+                              const std::vector<int>& srcOrigin,
+                              const std::vector<int>& regionSize) {
+    const TensorShape& srcShape = src->getShape();
+    const TensorShape& destShape = dest->getShape();
+    const int ndims = srcShape.ndims();
+    const size_t elemSize = src->getDataTypeSize();
+    std::vector<size_t> srcStrides(ndims), destStrides(ndims);
+    size_t srcStride = elemSize, destStride = elemSize;
+    RegionCopyPlan plan = { 0, 0, 0, {}, {}, {}, 1 };
+    for (int i = ndims - 1; i >= 0; i--) {
+        srcStrides[i] = srcStride;
+        destStrides[i] = destStride;
+        plan.srcOffset += srcOrigin[i] * srcStride;
+        plan.destOffset += destOrigin[i] * destStride;
+        srcStride *= srcShape.getStorageDim(i);
+        destStride *= destShape.getStorageDim(i);
+    }
+
+    // Rows of the innermost dimension that cover the whole dimension in both
+    // tensors, alignment padding included, are contiguous with the next row.
+    int last = ndims - 1;
+    bool fullRows = regionSize[last] == srcShape[last] &&
+                    regionSize[last] == destShape[last] &&
+                    srcShape.getStorageDim(last) ==
+                            destShape.getStorageDim(last);
+    plan.runBytes = (fullRows ? srcShape.getStorageDim(last)
+                              : regionSize[last]) * elemSize;
+    int dim = last - 1;
+    for (; dim >= 0; dim--) {
+        if (plan.runBytes != srcStrides[dim] ||
+            plan.runBytes != destStrides[dim])
+            break;
+        plan.runBytes *= regionSize[dim];
+    }
+    if (fullRows && dim < 0) {
+        // Don't copy the padding past the end of the region.
+        plan.runBytes -= srcShape.getPadding(last) * elemSize;
+    }
+
+    for (; dim >= 0; dim--) {
+        if (regionSize[dim] == 1)
+            continue;
+        if (!plan.counts.empty()) {
+            int& innerCount = plan.counts.front();
+            if (innerCount * plan.srcStrides.front() == srcStrides[dim] &&
+                innerCount * plan.destStrides.front() == destStrides[dim]) {
+                innerCount *= regionSize[dim];
+                plan.numRuns *= regionSize[dim];
+                continue;
+            }
+        }
+        plan.counts.insert(plan.counts.begin(), regionSize[dim]);
+        plan.srcStrides.insert(plan.srcStrides.begin(), srcStrides[dim]);
+        plan.destStrides.insert(plan.destStrides.begin(), destStrides[dim]);
+        plan.numRuns *= regionSize[dim];
+    }
+    return plan;
+}
+
+/** Copies one contiguous run, bypassing the caches if streaming is set. */
+void copyRun(char* dest, const char* src, size_t bytes, bool streaming) {
+#ifdef __SSE2__
+    if (streaming && bytes >= 64) {
+        size_t head = (16 - reinterpret_cast<uintptr_t>(dest) % 16) % 16;
+        std::memcpy(dest, src, head);
+        dest += head;
+        src += head;
+        bytes -= head;
+        size_t body = bytes & ~size_t(15);
+        for (size_t i = 0; i < body; i += 16) {
+            __m128i vec =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm_stream_si128(reinterpret_cast<__m128i*>(dest + i), vec);
+        }
+        std::memcpy(dest + body, src + body, bytes - body);
+        return;
+    }
+#endif
+    std::memcpy(dest, src, bytes);
+}
+
+/** Makes streaming stores visible to other threads. */
+void finishStreaming(bool streaming) {
+#ifdef __SSE2__
+    if (streaming)
+        _mm_sfence();
+#endif
+}
+
+/** Copies runs [begin, end) of the plan. */
+void copyRuns(const RegionCopyPlan& plan,
+              char* dest,
+              const char* src,
+              int begin,
+              int end,
+              bool streaming) {
+    const int nloops = plan.counts.size();
+    std::vector<int> index(nloops);
+    size_t srcOffset = plan.srcOffset, destOffset = plan.destOffset;
+    for (int i = nloops - 1, rest = begin; i >= 0; i--) {
+        index[i] = rest % plan.counts[i];
+        rest /= plan.counts[i];
+        srcOffset += index[i] * plan.srcStrides[i];
+        destOffset += index[i] * plan.destStrides[i];
+    }
+    for (int run = begin; run < end; run++) {
+        copyRun(dest + destOffset, src + srcOffset, plan.runBytes, streaming);
+        for (int i = nloops - 1; i >= 0; i--) {
+            srcOffset += plan.srcStrides[i];
+            destOffset += plan.destStrides[i];
+            if (++index[i] < plan.counts[i])
+                break;
+            srcOffset -= plan.counts[i] * plan.srcStrides[i];
+            destOffset -= plan.counts[i] * plan.destStrides[i];
+            index[i] = 0;
+        }
+    }
+    finishStreaming(streaming);
+}
+
+bool canCopyInParallel(size_t bytes) {
+    return bytes >= kParallelCopyBytes && threadPool && !fastForwardMode;
+}
+
+}  // namespace
+
+void bulkCopy(void* dest, const void* src, size_t bytes) {
+    bool streaming = bytes >= kStreamingCopyBytes;
+    char* destPtr = reinterpret_cast<char*>(dest);
+    const char* srcPtr = reinterpret_cast<const char*>(src);
+    if (!canCopyInParallel(bytes)) {
+        copyRun(destPtr, srcPtr, bytes, streaming);
+        finishStreaming(streaming);
+        return;
+    }
+    // Split the copy into one chunk per thread, in whole cache lines.
+    int numChunks = threadPool->size();
+    size_t chunkBytes = (bytes / numChunks + 63) & ~size_t(63);
+    threadPool->parallelFor(0, numChunks, 1, [&](int start, int end) {
+        for (int i = start; i < end; i++) {
+            size_t offset = std::min(i * chunkBytes, bytes);
+            size_t size = std::min(chunkBytes, bytes - offset);
+            copyRun(destPtr + offset, srcPtr + offset, size, streaming);
+        }
+        finishStreaming(streaming);
+    });
+}
+
+void bulkCopyRegion(Tensor* dest,
+                    Tensor* src,
+                    const std::vector<int>& destOrigin,
+                    const std::vector<int>& srcOrigin,
+                    const std::vector<int>& regionSize) {
+    if (product(regionSize) == 0)
+        return;
+    RegionCopyPlan plan =
+            planRegionCopy(dest, src, destOrigin, srcOrigin, regionSize);
+    char* destPtr = reinterpret_cast<char*>(dest->getStorage().get());
+    const char* srcPtr = reinterpret_cast<const char*>(src->getStorage().get());
+    if (plan.numRuns == 1) {
+        bulkCopy(destPtr + plan.destOffset, srcPtr + plan.srcOffset,
+                 plan.runBytes);
+        return;
+    }
+    size_t totalBytes = plan.numRuns * plan.runBytes;
+    bool streaming = totalBytes >= kStreamingCopyBytes;
+    if (!canCopyInParallel(totalBytes)) {
+        copyRuns(plan, destPtr, srcPtr, 0, plan.numRuns, streaming);
+        return;
+    }
+    int grainSize = std::ceil(plan.numRuns * 1.0 / threadPool->size());
+    threadPool->parallelFor(
+            0, plan.numRuns, grainSize, [&](int start, int end) {
+                copyRuns(plan, destPtr, srcPtr, start, end, streaming);
+            });
+}
+
+}  // namespace internal
+
 void copyTensorRegion(Tensor* dest,
                       Tensor* src,
                       std::vector<int> destOrigin,
@@ -217,8 +438,11 @@ TiledTensor generateTiledTensorPerBatchNC(Tensor* tensor,
         std::string tileName = op->getName() + ":" + tensor->getName() +
                                "/tile:" + std::to_string((int)tileIndex);
         Tensor* tile = new Tensor(tileName, currentShape);
-        tile->allocateStorage(tensor->getDataType());
-        tiledTensor.setTile(tileIndex, { srcOffset }, tile, copyData);
+        if (!tiledTensor.setTileView(tileIndex, { srcOffset }, tile)) {
+            tile->setAllocator(op->getWorkspace()->getPool());
+            tile->allocateStorage(tensor->getDataType());
+            tiledTensor.setTile(tileIndex, { srcOffset }, tile, copyData);
+        }
         srcOffset += currentTileSize;
         remainingSize -= currentTileSize;
     }
@@ -308,8 +532,11 @@ TiledTensor generateTiledTensorWithStrideAndPadding(
             std::string tileName = op->getName() + ":" + tensor->getName() +
                                    "/tile:" + std::to_string((int)tileIndex);
             Tensor* tile = new Tensor(tileName, currentShape);
-            tile->allocateStorage(tensor->getDataType());
-            tiledTensor.setTile(tileIndex, currentOrigin, tile, false);
+            if (!tiledTensor.setTileView(tileIndex, currentOrigin, tile)) {
+                tile->setAllocator(op->getWorkspace()->getPool());
+                tile->allocateStorage(tensor->getDataType());
+                tiledTensor.setTile(tileIndex, currentOrigin, tile, false);
+            }
             for (int i = ndims - 1; i >= 0; i--) {
                 currentOrigin[i] += currentShape[i];
                 if (currentOrigin[i] >= inputShape[i]) {
@@ -68,51 +68,46 @@ void writeTensorToOstream(std::ostream& os, const Tensor& tensor) {
 
 namespace internal {
 
+/**
+ * Copies a linear block of memory. Large copies are split across the thread
+ * pool, and copies too large to stay in the cache use streaming stores.
+ */
+void bulkCopy(void* dest, const void* src, size_t bytes);
+
+/**
+ * Copies a region between two Tensors of any data type.
+ *
+ * The region is copied as a series of contiguous runs: rows that continue
+ * each other in both Tensors are merged into a single run, and the loops over
+ * the runs are collapsed wherever possible. Large regions are split across
+ * the thread pool and copied with streaming stores, like bulkCopy().
+ */
+void bulkCopyRegion(Tensor* dest,
+                    Tensor* src,
+                    const std::vector<int>& destOrigin,
+                    const std::vector<int>& srcOrigin,
+                    const std::vector<int>& regionSize);
+
 template <typename DType>
 void copyTensorRegion(Tensor* dest,
                       Tensor* src,
                       const std::vector<int>& destOrigin,
                       const std::vector<int>& srcOrigin,
                       const std::vector<int>& regionSize) {
+#ifdef PEDANTIC
     const TensorShape& srcShape = src->getShape();
     const TensorShape& destShape = dest->getShape();
-    TensorShape regionShape(
-            regionSize, srcShape.getLayout(), srcShape.getAlignment());
-    const int ndims = srcShape.ndims();
     auto destIt = TensorRegionIndexIterator(destShape, destOrigin, regionSize);
     auto srcIt = TensorRegionIndexIterator(srcShape, srcOrigin, regionSize);
-
-    // We know where to copy data from and how much data we should copy (the
-    // data region), now starting from the last dimension, we figure out how
-    // much contiguous data there exists such that we can apply more efficient
-    // data copy mechanisms (memcpy).
-    std::vector<int> contiguousRegion(ndims, 1);
-    int contiguousSize = 1;
-    for (int i = ndims - 1; i >= 0; i--) {
-        contiguousSize *= regionShape.getStorageDim(i);
-        contiguousRegion[i] = regionShape[i];
-        // If we find a region dimension smaller than that of either src or
-        // dest tensor, then the next region dimension must not be contiguous.
-        if (regionShape[i] < srcShape[i] || regionShape[i] < destShape[i])
-            break;
-    }
-
-    // Copy the data region from the src tensor to the dest tensor.
     DType* destPtr = dest->template data<DType>();
     DType* srcPtr = src->template data<DType>();
-    while (!srcIt.end() && !destIt.end()) {
-#ifdef PEDANTIC
+    for (; !srcIt.end() && !destIt.end(); ++srcIt, ++destIt)
         destPtr[destIt] = srcPtr[srcIt];
-        ++destIt;
-        ++srcIt;
 #else
-        memcpy(&destPtr[destIt],
-               &srcPtr[srcIt],
-               contiguousSize * sizeof(DType));
-        destIt += contiguousRegion;
-        srcIt += contiguousRegion;
+    // Let the bulk copy engine figure out how much contiguous data there is
+    // and copy it with memcpy.
+    bulkCopyRegion(dest, src, destOrigin, srcOrigin, regionSize);
 #endif
-    }
 }
 
 template <typename DType>
@@ -123,8 +118,9 @@ void copyRawTensorData(Tensor* dest,
                        int copySize) {
     DType* destPtr = dest->template data<DType>();
     DType* srcPtr = src->template data<DType>();
-    std::memcpy(
-            &destPtr[destOffset], &srcPtr[srcOffset], copySize * sizeof(DType));
+    bulkCopy(&destPtr[destOffset],
+             &srcPtr[srcOffset],
+             copySize * sizeof(DType));
 }
 
 template <typename DType>
@@ -4,6 +4,9 @@
 #include <map>
 #include <string>
 
+#include "smaug/core/allocator.h"
+#include "smaug/core/globals.h"
+#include "smaug/core/param_file.h"
 #include "smaug/core/tensor.h"
 #include "smaug/core/operator.h"
 
@@ -22,8 +25,14 @@ class Workspace {
             delete tensor.second;
     }
 
+    /**
+     * Adds the Tensor to the Workspace. Unless it already has an allocator,
+     * its storage will be allocated from the arena.
+     */
     Tensor* addTensor(Tensor* tensor) {
         tensors[tensor->getName()] = static_cast<TensorBase*>(tensor);
+        if (!tensor->getAllocator())
+            tensor->setAllocator(getArena());
         return tensor;
     }
 
@@ -44,8 +53,33 @@ class Workspace {
         return getTensor(op->getName());
     }
 
+    /**
+     * Returns the allocator for the storage of Tensors that is allocated once
+     * and kept, or null if arena allocators are disabled.
+     */
+    Allocator* getArena() { return useArenaAllocators ? &arena : nullptr; }
+
+    /**
+     * Returns the allocator for storage that is repeatedly freed and
+     * allocated again, like that of tiles, or null if arena allocators are
+     * disabled.
+     */
+    Allocator* getPool() { return useArenaAllocators ? &pool : nullptr; }
+
+    /**
+     * Sets the memory mapped parameters file that the storage of data Tensors
+     * may be in.
+     */
+    void setParamFile(std::shared_ptr<ParamFile> _paramFile) {
+        paramFile = _paramFile;
+    }
+    ParamFile* getParamFile() const { return paramFile.get(); }
+
    protected:
     std::map<std::string, TensorBase*> tensors;
+    ArenaAllocator arena;
+    SizeClassPool pool;
+    std::shared_ptr<ParamFile> paramFile;
 };
 
 }
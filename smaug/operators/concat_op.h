@@ -67,6 +67,8 @@ class ConcatOp : public Operator {
         createOutputTensor();
     }
 
+    bool isHostOnly() const override { return true; }
+
     void run() override {
         Tensor* output = getOutput(0);
         int ndims = output->ndims();
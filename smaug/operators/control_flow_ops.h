@@ -61,6 +61,8 @@ class SwitchOp : public Operator {
         outputs.at(OutputTrue) = outputTrue;
     }
 
+    bool isHostOnly() const override { return true; }
+
     void run() override {
         Tensor* input = getInput(Input);
         Tensor* outputFalse = getOutput(OutputFalse);
@@ -112,6 +114,8 @@ class MergeOp : public Operator {
         return true;
     }
 
+    bool isHostOnly() const override { return true; }
+
     void run() override {
         Tensor* output = getOutput(0);
         bool forwarded = false;
@@ -33,6 +33,7 @@ class DataOp : public Operator {
     }
 
     void run() override {}
+    bool isHostOnly() const override { return true; }
     bool validate() override { return data != NULL && Operator::validate(); }
     void createAllTensors() override {}
 
@@ -32,6 +32,8 @@ class ReorderOp : public Operator {
     DataLayout getTargetDataLayout() const { return targetLayout; }
     void setTargetLayout(DataLayout layout) { targetLayout = layout; }
 
+    bool isHostOnly() const override { return true; }
+
     void run() override {
         auto stats = gem5::ScopedStats(
                 stats::kReorderingStart, stats::kReorderingEnd);
@@ -1,44 +1,137 @@
+#ifndef _OPERATORS_REORDER_OP_IMPL_H_
+#define _OPERATORS_REORDER_OP_IMPL_H_
+
+#include <algorithm>
+#include <cmath>
+
+#include "smaug/core/globals.h"
 #include "smaug/core/tensor.h"
 #include "smaug/core/tensor_utils.h"
+#include "smaug/utility/thread_pool.h"
 
 namespace smaug {
 
+/** The side of the square blocks that transposes are broken up into. */
+constexpr int kTransposeBlockSize = 8;
+
+/**
+ * Transposes a kTransposeBlockSize x kTransposeBlockSize block. The loop
+ * bounds are compile-time constants, so the compiler fully unrolls and
+ * vectorizes this.
+ */
 template <typename DType>
-void convertNchwToNhwcImpl(Tensor* input, Tensor* output) {
-    TensorIndexIterator inputIdx = input->startIndex();
-    TensorIndexIterator outputIdx = output->startIndex();
-    const TensorShape& inputShape = input->getShape();
-    DType* inputData = input->template data<DType>();
-    DType* outputData = output->template data<DType>();
-    for (int n = 0; n < inputShape[0]; n++) {
-        for (int c = 0; c < inputShape[1]; c++) {
-            for (int h = 0; h < inputShape[2]; h++) {
-                for (int w = 0; w < inputShape[3]; w++) {
-                    outputData[outputIdx(n, h, w, c)] =
-                            inputData[inputIdx(n, c, h, w)];
-                }
+void transposeFullBlock(const DType* src,
+                        int srcStride,
+                        DType* dest,
+                        int destStride) {
+    DType block[kTransposeBlockSize][kTransposeBlockSize];
+    for (int i = 0; i < kTransposeBlockSize; i++) {
+        for (int j = 0; j < kTransposeBlockSize; j++)
+            block[j][i] = src[i * srcStride + j];
+    }
+    for (int j = 0; j < kTransposeBlockSize; j++) {
+        for (int i = 0; i < kTransposeBlockSize; i++)
+            dest[j * destStride + i] = block[j][i];
+    }
+}
+
+/**
+ * Transposes a rows x cols matrix at src into a cols x rows matrix at dest.
+ *
+ * Consecutive rows of src are srcStride elements apart, and consecutive rows
+ * of dest are destStride elements apart. The matrix is transposed in square
+ * blocks so that both the reads and the writes of a block stay within a few
+ * cache lines.
+ */
+template <typename DType>
+void transposeMatrix(const DType* src,
+                     int srcStride,
+                     DType* dest,
+                     int destStride,
+                     int rows,
+                     int cols) {
+    for (int r = 0; r < rows; r += kTransposeBlockSize) {
+        int blockRows = std::min(kTransposeBlockSize, rows - r);
+        for (int c = 0; c < cols; c += kTransposeBlockSize) {
+            int blockCols = std::min(kTransposeBlockSize, cols - c);
+            const DType* srcBlock = &src[r * srcStride + c];
+            DType* destBlock = &dest[c * destStride + r];
+            if (blockRows == kTransposeBlockSize &&
+                blockCols == kTransposeBlockSize) {
+                transposeFullBlock(srcBlock, srcStride, destBlock, destStride);
+                continue;
+            }
+            for (int i = 0; i < blockRows; i++) {
+                for (int j = 0; j < blockCols; j++)
+                    destBlock[j * destStride + i] = srcBlock[i * srcStride + j];
             }
         }
     }
 }
 
+/**
+ * Calls func(i) for every i in [0, num), spreading the calls over the thread
+ * pool if there is one.
+ */
+template <typename Func>
+void parallelForEach(int num, const Func& func) {
+    if (!threadPool || fastForwardMode || num == 1) {
+        for (int i = 0; i < num; i++)
+            func(i);
+        return;
+    }
+    int grainSize = std::ceil(num * 1.0 / threadPool->size());
+    threadPool->parallelFor(0, num, grainSize, [&func](int start, int end) {
+        for (int i = start; i < end; i++)
+            func(i);
+    });
+}
+
+
+template <typename DType>
+void convertNchwToNhwcImpl(Tensor* input, Tensor* output) {
+    const TensorShape& inputShape = input->getShape();
+    const TensorShape& outputShape = output->getShape();
+    const int N = inputShape[0], C = inputShape[1], H = inputShape[2],
+              W = inputShape[3];
+    const int inputRowSize = inputShape.getStorageDim(3);
+    const int outputRowSize = outputShape.getStorageDim(3);
+    const DType* inputData = input->template data<DType>();
+    DType* outputData = output->template data<DType>();
+    // Each row of the image is a C x W matrix in NCHW, and a W x C matrix in
+    // NHWC.
+    parallelForEach(N * H, [&](int nh) {
+        int n = nh / H, h = nh % H;
+        transposeMatrix(&inputData[(n * C * H + h) * inputRowSize],
+                        H * inputRowSize,
+                        &outputData[nh * W * outputRowSize],
+                        outputRowSize,
+                        C,
+                        W);
+    });
+}
+
 template <typename DType>
 void convertNhwcToNchwImpl(Tensor* input, Tensor* output) {
-    TensorIndexIterator inputIdx = input->startIndex();
-    TensorIndexIterator outputIdx = output->startIndex();
     const TensorShape& inputShape = input->getShape();
-    DType* inputData = input->template data<DType>();
+    const TensorShape& outputShape = output->getShape();
+    const int N = inputShape[0], H = inputShape[1], W = inputShape[2],
+              C = inputShape[3];
+    const int inputRowSize = inputShape.getStorageDim(3);
+    const int outputRowSize = outputShape.getStorageDim(3);
+    const DType* inputData = input->template data<DType>();
     DType* outputData = output->template data<DType>();
-    for (int n = 0; n < inputShape[0]; n++) {
-        for (int h = 0; h < inputShape[1]; h++) {
-            for (int w = 0; w < inputShape[2]; w++) {
-                for (int c = 0; c < inputShape[3]; c++) {
-                    outputData[outputIdx(n, c, h, w)] =
-                            inputData[inputIdx(n, h, w, c)];
-                }
-            }
-        }
-    }
+    // Each row of the image is a W x C matrix in NHWC, and a C x W matrix in
+    // NCHW.
+    parallelForEach(N * H, [&](int nh) {
+        int n = nh / H, h = nh % H;
+        transposeMatrix(&inputData[nh * W * inputRowSize],
+                        inputRowSize,
+                        &outputData[(n * C * H + h) * outputRowSize],
+                        H * outputRowSize,
+                        W,
+                        C);
+    });
 }
 
 template <typename DType>
@@ -73,32 +166,42 @@ void flattenImpl(Tensor* input, Tensor* output) {
 
 template <typename DType>
 void transpose3DImpl(Tensor* input, Tensor* output) {
-    TensorIndexIterator inputIdx = input->startIndex();
-    TensorIndexIterator outputIdx = output->startIndex();
     const TensorShape& inputShape = input->getShape();
-    auto inputData = input->template data<DType>();
-    auto outputData = output->template data<DType>();
-    for (int i = 0; i < inputShape[0]; i++) {
-        for (int j = 0; j < inputShape[1]; j++) {
-            for (int k = 0; k < inputShape[2]; k++) {
-                outputData[outputIdx(i, k, j)] = inputData[inputIdx(i, j, k)];
-            }
-        }
-    }
+    const TensorShape& outputShape = output->getShape();
+    const int inputRowSize = inputShape.getStorageDim(2);
+    const int outputRowSize = outputShape.getStorageDim(2);
+    const DType* inputData = input->template data<DType>();
+    DType* outputData = output->template data<DType>();
+    parallelForEach(inputShape[0], [&](int i) {
+        transposeMatrix(&inputData[i * inputShape[1] * inputRowSize],
+                        inputRowSize,
+                        &outputData[i * inputShape[2] * outputRowSize],
+                        outputRowSize,
+                        inputShape[1],
+                        inputShape[2]);
+    });
 }
 
 template <typename DType>
 void transpose2DImpl(Tensor* input, Tensor* output) {
-    TensorIndexIterator inputIdx = input->startIndex();
-    TensorIndexIterator outputIdx = output->startIndex();
     const TensorShape& inputShape = input->getShape();
-    auto inputData = input->template data<DType>();
-    auto outputData = output->template data<DType>();
-    for (int n = 0; n < inputShape[0]; n++) {
-        for (int c = 0; c < inputShape[1]; c++) {
-            outputData[outputIdx(c, n)] = inputData[inputIdx(n, c)];
-        }
-    }
+    const int inputRowSize = inputShape.getStorageDim(1);
+    const int outputRowSize = output->getShape().getStorageDim(1);
+    const DType* inputData = input->template data<DType>();
+    DType* outputData = output->template data<DType>();
+    // Split the rows into bands of whole blocks, so that each band writes to
+    // a disjoint set of columns of the output.
+    const int numBands =
+            (inputShape[0] + kTransposeBlockSize - 1) / kTransposeBlockSize;
+    parallelForEach(numBands, [&](int band) {
+        int row = band * kTransposeBlockSize;
+        transposeMatrix(&inputData[row * inputRowSize],
+                        inputRowSize,
+                        &outputData[row],
+                        outputRowSize,
+                        std::min(kTransposeBlockSize, inputShape[0] - row),
+                        inputShape[1]);
+    });
 }
 
 void convertNchwToNhwc(Tensor* input, Tensor* output);
@@ -112,3 +215,5 @@ void transpose3D(Tensor* input, Tensor* output);
 void transpose2D(Tensor* input, Tensor* output);
 
 }  // namespace smaug
+
+#endif
@@ -1,8 +1,10 @@
 #include "catch.hpp"
 #include "smaug/core/backend.h"
 #include "smaug/core/tensor.h"
+#include "smaug/core/globals.h"
 #include "smaug/core/smaug_test.h"
 #include "smaug/operators/reorder_op.h"
+#include "smaug/utility/thread_pool.h"
 
 using namespace smaug;
 
@@ -93,3 +95,103 @@ TEST_CASE_METHOD(SmaugTest, "Reorder from NHWC", "[refop]") {
         verifyOutputs(outputsTensor, inputValues);
     }
 }
+
+class BlockedReorderTest : public SmaugTest {
+   public:
+    ~BlockedReorderTest() {
+        delete threadPool;
+        threadPool = nullptr;
+        fastForwardMode = true;
+    }
+
+    /** Runs the reorders on a thread pool of this size, if nonzero. */
+    void useThreadPool(int numThreads) {
+        if (numThreads == 0)
+            return;
+        threadPool = new ThreadPool(numThreads, ThreadPool::Block);
+        threadPool->initThreadPool();
+        fastForwardMode = false;
+    }
+
+    /** Creates an input tensor whose elements count up from zero. */
+    Tensor* newInput(const TensorShape& shape, std::vector<float16>& values) {
+        Tensor* input = new Tensor("input", shape);
+        input->allocateStorage<float16>();
+        workspace()->addTensor(input);
+        float16* data = input->data<float16>();
+        for (auto idx = input->startIndex(); !idx.end(); ++idx) {
+            values.push_back(fp16(values.size()));
+            data[idx] = values.back();
+        }
+        return input;
+    }
+
+    Tensor* reorder(Tensor* input, DataLayout targetLayout) {
+        auto reorderOp = new ReorderOp<SmvBackend>(
+                input->getName() + "_reorder", targetLayout, workspace());
+        reorderOp->setInput(input, 0);
+        reorderOp->createAllTensors();
+        allocateAllTensors<float16>(reorderOp);
+        reorderOp->run();
+        return reorderOp->getOutput(0);
+    }
+};
+
+TEST_CASE_METHOD(BlockedReorderTest,
+                 "Blocked reorders of padded tensors",
+                 "[refop]") {
+    useThreadPool(GENERATE(0, 2));
+
+    SECTION("NCHW to NHWC and back") {
+        // Neither transposed dimension is a multiple of the transpose block
+        // size, and the innermost dimension of every tensor is padded.
+        const int N = 2, C = 11, H = 3, W = 13;
+        std::vector<float16> inputValues;
+        Tensor* input = newInput(TensorShape({ N, C, H, W }, DataLayout::NCHW,
+                                             SmvBackend::Alignment),
+                                 inputValues);
+        Tensor* nhwc = reorder(input, DataLayout::NHWC);
+        std::vector<float16> expectedValues;
+        for (int n = 0; n < N; n++) {
+            for (int h = 0; h < H; h++) {
+                for (int w = 0; w < W; w++) {
+                    for (int c = 0; c < C; c++)
+                        expectedValues.push_back(
+                                fp16(((n * C + c) * H + h) * W + w));
+                }
+            }
+        }
+        verifyOutputs(nhwc, expectedValues);
+        verifyOutputs(reorder(nhwc, DataLayout::NCHW), inputValues);
+    }
+
+    SECTION("3D transpose") {
+        const int N = 2, C = 9, T = 17;
+        std::vector<float16> inputValues;
+        Tensor* input = newInput(TensorShape({ N, C, T }, DataLayout::NCT,
+                                             SmvBackend::Alignment),
+                                 inputValues);
+        std::vector<float16> expectedValues;
+        for (int n = 0; n < N; n++) {
+            for (int t = 0; t < T; t++) {
+                for (int c = 0; c < C; c++)
+                    expectedValues.push_back(fp16((n * C + c) * T + t));
+            }
+        }
+        verifyOutputs(reorder(input, DataLayout::NTC), expectedValues);
+    }
+
+    SECTION("2D transpose") {
+        const int N = 19, C = 10;
+        std::vector<float16> inputValues;
+        Tensor* input = newInput(
+                TensorShape({ N, C }, DataLayout::NC, SmvBackend::Alignment),
+                inputValues);
+        std::vector<float16> expectedValues;
+        for (int c = 0; c < C; c++) {
+            for (int n = 0; n < N; n++)
+                expectedValues.push_back(fp16(n * C + c));
+        }
+        verifyOutputs(reorder(input, DataLayout::CN), expectedValues);
+    }
+}
@@ -67,6 +67,8 @@ class RepeatOp : public Operator {
         outputs.at(0) = output;
     }
 
+    bool isHostOnly() const override { return true; }
+
     void run() override {
         Tensor* input = getInput(0);
         Tensor* output = getOutput(0);
@@ -56,6 +56,8 @@ class ReshapeOp : public Operator {
         outputs.at(0) = output;
     }
 
+    bool isHostOnly() const override { return true; }
+
     void run() override {
         // Copy the input data.
         Tensor* input = getInput(0);
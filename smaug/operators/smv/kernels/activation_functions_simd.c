@@ -1,3 +1,5 @@
+#include <float.h>
+
 #include "smaug/operators/common.h"
 #include "smaug/operators/smv/kernels/load_store_fp16_data.h"
 #include "smaug/operators/smv/kernels/activation_functions_simd.h"
@@ -79,6 +81,108 @@ void smv_softmax_nc_vec_fxp(float16* host_inputs,
             results, host_results, input_num * (input_size + input_pad), 0, 0);
 }
 
+/** \ingroup AladdinKernels
+ *
+ * Top level function for softmax on inputs tiled along the activations.
+ *
+ * A batch tile is run in two passes over its activation-wise tiles. In the
+ * reduction pass, each tile updates the running max of every input and the sum
+ * of the exponentials scaled to that max (online softmax). In the
+ * normalization pass, each tile is exponentiated against the final max and
+ * divided by the final sum.
+ *
+ * @param host_inputs Host buffer for the input tile.
+ * @param host_results Host buffer for the output tile.
+ * @param inputs Local buffer for the input tile.
+ * @param results Local buffer for the output tile.
+ * @param stats Local buffer for the running max (the first input_num elements)
+ *        and sum (the next input_num elements) of each input.
+ * @param input_num Batch size of the tile.
+ * @param input_size Number of activations per input in the tile.
+ * @param input_pad Alignment padding.
+ * @param normalize Run the normalization pass if true, otherwise the
+ *        reduction pass.
+ * @param init_stats Reset the stats in the reduction pass. Set for the first
+ *        tile of the inputs.
+ * @param read_inputs Load inputs from the host. Set to false if the input
+ *        tile is still in the local buffer from the last invocation.
+ */
+void smv_softmax_tiled_nc_vec_fxp(float16* host_inputs,
+                                  float16* host_results,
+                                  float* inputs,
+                                  float* results,
+                                  float* stats,
+                                  int input_num,
+                                  int input_size,
+                                  int input_pad,
+                                  bool normalize,
+                                  bool init_stats,
+                                  bool read_inputs) {
+    // Load inputs if needed.
+    if (read_inputs) {
+        host_load_fp16(inputs, host_inputs,
+                       input_num * (input_size + input_pad), 0, 0);
+    }
+
+    VEC_ARRAY_2D(v8fp_t, _inputs, inputs, input_size + input_pad);
+    VEC_ARRAY_2D(v8fp_t, _results, results, input_size + input_pad);
+    float* maxes = stats;
+    float* sums = stats + input_num;
+    int input_vec_size = FRAC_CEIL(input_size, VECTOR_SIZE);
+
+    softmax_tiled_batch:
+    for (int i = 0; i < input_num; i++) {
+        if (!normalize) {
+            // Find the max of this tile.
+            float tile_max = -FLT_MAX;
+            softmax_tiled_max:
+            for (int j = 0; j < input_vec_size; j++) {
+                softmax_tiled_max_vec:
+                for (int k = 0; k < VECTOR_SIZE; k++) {
+                    if (j * VECTOR_SIZE + k < input_size)
+                        tile_max = max2(tile_max, _inputs[i][j][k]);
+                }
+            }
+
+            // Rescale the running sum to the new max, then add the
+            // exponentials of this tile.
+            float new_max = init_stats ? tile_max : max2(maxes[i], tile_max);
+            float sum = init_stats ? 0 : sums[i] * exp(maxes[i] - new_max);
+            softmax_tiled_sum:
+            for (int j = 0; j < input_vec_size; j++) {
+                softmax_tiled_sum_vec:
+                for (int k = 0; k < VECTOR_SIZE; k++) {
+                    if (j * VECTOR_SIZE + k < input_size)
+                        sum += exp(_inputs[i][j][k] - new_max);
+                }
+            }
+            maxes[i] = new_max;
+            sums[i] = sum;
+        } else {
+            // Precompute the division so that later we can just do a
+            // multiplication.
+            float normaliz = 1.0 / (sums[i] + 1e-6);
+            softmax_tiled_norm:
+            for (int j = 0; j < input_vec_size; j++) {
+                softmax_tiled_norm_vec:
+                for (int k = 0; k < VECTOR_SIZE; k++) {
+                    _results[i][j][k] =
+                            j * VECTOR_SIZE + k < input_size
+                                    ? exp(_inputs[i][j][k] - maxes[i]) *
+                                              normaliz
+                                    : 0;
+                }
+            }
+        }
+    }
+
+    // Store results to the host memory.
+    if (normalize) {
+        host_store_fp16(results, host_results,
+                        input_num * (input_size + input_pad), 0, 0);
+    }
+}
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
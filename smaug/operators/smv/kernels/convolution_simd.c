@@ -43,6 +43,12 @@ extern "C" {
  *        for non-first weight tiles.
  * @param read_inputs Load inputs from the host. Set to false if the input
  *        activations can be reused from the last invocation.
+ * @param reuse_rows If read_inputs is true, the number of leading rows of the
+ *        inputs that are still in the local inputs buffer from the last
+ *        invocation, as the trailing rows of the previous row tile. These are
+ *        moved to the top of the buffer, and only the other rows are loaded.
+ * @param reuse_src_row The row of the local inputs buffer that the reused
+ *        rows start at.
  * @param read_weights Load weights from the host. Set to false if the weights
  *        can be reused from the last invocation.
  * @param send_results Send the results to the host memory if this is true.
@@ -69,6 +75,8 @@ void smv_conv3d_nhwc_vec_fxp(float16* host_inputs,
                              int kern_start,
                              bool accumulate,
                              bool read_inputs,
+                             int reuse_rows,
+                             int reuse_src_row,
                              bool read_weights,
                              bool send_results,
                              activation_type act_function,
@@ -121,9 +129,22 @@ void smv_conv3d_nhwc_vec_fxp(float16* host_inputs,
     int num_eff_kernels = min2(weights_dims[0], result_height);
     int num_kernel_blocks = (num_eff_kernels - 1) / NUM_PE_INSTS;
 
-    // Load inputs and weights if needed.
-    if (read_inputs)
+    // Load inputs and weights if needed. With a sliding window over the rows,
+    // the rows that overlap with the previous row tile are already in the
+    // scratchpad, so only the new rows are loaded.
+    if (read_inputs && reuse_rows > 0) {
+        int row_size = a_cols * (a_height + a_pad);
+        int reuse_size = reuse_rows * row_size;
+        int reuse_src = reuse_src_row * row_size;
+        VEC_ARRAY_1D(v8fp_t, _inputs, inputs);
+        slide_window:
+        for (int i = 0; i < reuse_size / VECTOR_SIZE; i++)
+            _inputs[i] = _inputs[reuse_src / VECTOR_SIZE + i];
+        host_load_fp16(inputs, host_inputs, inputs_size - reuse_size,
+                       reuse_size, reuse_size);
+    } else if (read_inputs) {
         host_load_fp16(inputs, host_inputs, inputs_size, 0, 0);
+    }
     if (read_weights)
         host_load_fp16(weights, host_weights, weights_size, 0, 0);
 
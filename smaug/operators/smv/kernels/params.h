@@ -7,8 +7,15 @@
 #error "Existing VECTOR_SIZE is incompatible with SMV!"
 #endif
 
+// The datapath of the kernels. These can be overridden at build time to model
+// a different accelerator; the tiling optimizers take the PE and MACC counts
+// from smv::kNumPEs and smv::kNumMaccsPerPE, which default to these.
+#ifndef NUM_MACC_INSTS
 #define NUM_MACC_INSTS 4
+#endif
+#ifndef NUM_PE_INSTS
 #define NUM_PE_INSTS 8
+#endif
 
 #define DATA_PE_ALIGNMENT (NUM_MACC_INSTS)*(VECTOR_SIZE)
 
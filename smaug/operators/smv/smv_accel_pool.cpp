@@ -1,3 +1,5 @@
+#include <cassert>
+#include <fstream>
 #include <string>
 
 #include "smaug/operators/common.h"
@@ -6,8 +8,47 @@
 
 namespace smaug {
 
+AcceleratorDispatchPolicy accelDispatchPolicy = RoundRobin;
+AcceleratorDispatchLog accelDispatchLog;
+
+int AcceleratorDispatchLog::replay() {
+    assert(replayPos < decisions.size() &&
+           "The accelerator dispatch log has no more decisions to replay!");
+    return decisions[replayPos++];
+}
+
+bool AcceleratorDispatchLog::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    decisions.clear();
+    int accelIdx;
+    while (file >> accelIdx)
+        decisions.push_back(accelIdx);
+    replaying = true;
+    replayPos = 0;
+    return true;
+}
+
+void AcceleratorDispatchLog::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Unable to write the accelerator dispatch log to " << path
+                  << ".\n";
+        return;
+    }
+    for (int accelIdx : decisions)
+        file << accelIdx << "\n";
+}
+
+void AcceleratorDispatchLog::clear() {
+    decisions.clear();
+    replaying = false;
+    replayPos = 0;
+}
+
 SmvAcceleratorPool::SmvAcceleratorPool(int _size)
-        : size(_size), finishFlags(_size) {}
+        : size(_size), finishFlags(_size), finishCallbacks(_size) {}
 
 void SmvAcceleratorPool::addFinishFlag(
         int accelIdx, std::unique_ptr<volatile int> finishFlag) {
@@ -16,8 +57,16 @@ void SmvAcceleratorPool::addFinishFlag(
     }
 }
 
+void SmvAcceleratorPool::addFinishCallback(int accelIdx,
+                                           std::function<void()> callback) {
+    if (runningInSimulation)
+        finishCallbacks[accelIdx].push_back(std::move(callback));
+    else
+        callback();
+}
+
 void SmvAcceleratorPool::join(int accelIdx) {
-    if (finishFlags[accelIdx].empty())
+    if (finishFlags[accelIdx].empty() && finishCallbacks[accelIdx].empty())
         return;
 
     while (!finishFlags[accelIdx].empty()) {
@@ -26,23 +75,74 @@ void SmvAcceleratorPool::join(int accelIdx) {
         waitForAccelerator(finishFlag.get());
         finishFlags[accelIdx].pop_front();
     }
+    runFinishCallbacks(accelIdx);
+}
+
+bool SmvAcceleratorPool::poll(int accelIdx) {
+    std::deque<std::unique_ptr<volatile int>>& flags = finishFlags[accelIdx];
+    while (!flags.empty() && *flags.front() != NOT_COMPLETED)
+        flags.pop_front();
+    if (!flags.empty())
+        return false;
+    if (!finishCallbacks[accelIdx].empty())
+        runFinishCallbacks(accelIdx);
+    return true;
+}
+
+void SmvAcceleratorPool::runFinishCallbacks(int accelIdx) {
     dout(1) << "Accelerator " << accelIdx << " finished.\n";
+    for (auto& callback : finishCallbacks[accelIdx])
+        callback();
+    finishCallbacks[accelIdx].clear();
 }
 
 void SmvAcceleratorPool::joinAll() {
     dout(1) << "Waiting for all accelerators to finish.\n";
-    for (int i = 0; i < size; i++)
-        join(i);
+    std::vector<bool> finished(size, false);
+    int numFinished = 0;
+    while (numFinished < size) {
+        for (int i = 0; i < size; i++) {
+            if (!finished[i] && poll(i)) {
+                finished[i] = true;
+                numFinished++;
+            }
+        }
+    }
     dout(1) << "All accelerators finished.\n";
 }
 
+int SmvAcceleratorPool::waitForAnyAccelerator(int currAccelIdx) {
+    // Start after the current accelerator, so that ties are broken the same
+    // way as the round-robin policy would.
+    while (true) {
+        for (int i = 1; i <= size; i++) {
+            int accelIdx = (currAccelIdx + i) % size;
+            if (poll(accelIdx))
+                return accelIdx;
+        }
+    }
+}
+
 int SmvAcceleratorPool::getNextAvailableAccelerator(int currAccelIdx) {
-    // Round-robin policy.
-    int pickedAccel = currAccelIdx + 1;
-    if (pickedAccel == size)
-        pickedAccel = 0;
-    // If the picked accelerator has not finished, wait until it returns.
-    join(pickedAccel);
+    int pickedAccel;
+    if (accelDispatchPolicy == FirstFinished) {
+        if (accelDispatchLog.isReplaying()) {
+            pickedAccel = accelDispatchLog.replay();
+            assert(pickedAccel < size &&
+                   "The accelerator dispatch log does not match this pool!");
+            join(pickedAccel);
+        } else {
+            pickedAccel = waitForAnyAccelerator(currAccelIdx);
+            accelDispatchLog.record(pickedAccel);
+        }
+    } else {
+        // Round-robin policy.
+        pickedAccel = currAccelIdx + 1;
+        if (pickedAccel == size)
+            pickedAccel = 0;
+        // If the picked accelerator has not finished, wait until it returns.
+        join(pickedAccel);
+    }
     if (size > 1)
         dout(1) << "Switched to accelerator " << pickedAccel << ".\n";
     return pickedAccel;
@@ -3,18 +3,79 @@
 
 #include <vector>
 #include <deque>
+#include <functional>
 #include <memory>
+#include <string>
 
 namespace smaug {
 
+/** The policies for picking the accelerator that runs the next tile. */
+enum AcceleratorDispatchPolicy {
+    /** Cycle through the accelerators, waiting for each one in turn. */
+    RoundRobin,
+    /** Pick whichever accelerator finishes its queued work first. */
+    FirstFinished,
+};
+
+/** The dispatch policy used by all SmvAcceleratorPools. */
+extern AcceleratorDispatchPolicy accelDispatchPolicy;
+
+/**
+ * Records the accelerators picked by the FirstFinished policy, so that the
+ * same assignment of tiles to accelerators can be replayed later.
+ *
+ * Which accelerator finishes first depends on simulated timing, but the
+ * dynamic traces for each accelerator must be generated with exactly the same
+ * assignment that the simulation will make. The decisions made in a simulation
+ * are therefore recorded and saved, and trace generation replays them instead
+ * of making its own.
+ *
+ * The log is one flat sequence of decisions for the whole network, so the
+ * accelerator operators must be run in the same order each time (i.e. with the
+ * sequential Scheduler).
+ */
+class AcceleratorDispatchLog {
+   public:
+    AcceleratorDispatchLog() : replaying(false), replayPos(0) {}
+
+    /** Returns true if decisions are read from the log instead of made. */
+    bool isReplaying() const { return replaying; }
+
+    /** Appends a decision to the log. */
+    void record(int accelIdx) { decisions.push_back(accelIdx); }
+
+    /** Returns the next decision to replay. */
+    int replay();
+
+    /** Loads the decisions in the file and starts replaying them. */
+    bool load(const std::string& path);
+
+    /** Writes all recorded decisions to the file. */
+    void save(const std::string& path) const;
+
+    void clear();
+    int size() const { return decisions.size(); }
+
+   protected:
+    std::vector<int> decisions;
+    bool replaying;
+    int replayPos;
+};
+
+/** The log shared by all SmvAcceleratorPools. */
+extern AcceleratorDispatchLog accelDispatchLog;
+
 /**
  * Implements a pool of worker accelerators.
  *
  * For operators that require work tiling, tiles can be distributed across
- * multiple accelerators to exploit parallelism. This class implements a
- * deterministic round-robin worker pool. Determinism is required because when
- * generating multiple dynamic traces, worker accelerator assignments must
- * match with simulation of the binary in gem5.
+ * multiple accelerators to exploit parallelism. By default, this class
+ * implements a deterministic round-robin worker pool. Determinism is required
+ * because when generating multiple dynamic traces, worker accelerator
+ * assignments must match with simulation of the binary in gem5. With the
+ * FirstFinished policy, the next tile goes to whichever accelerator becomes
+ * idle first instead, which keeps all accelerators busy when tiles have uneven
+ * costs; determinism is then provided by the AcceleratorDispatchLog.
  *
  * To use:
  *
@@ -36,16 +97,31 @@ class SmvAcceleratorPool {
     /** Add a finish flag for the specified accelerator. */
     void addFinishFlag(int accelIdx, std::unique_ptr<volatile int> finishFlag);
 
-    /** Wait until all the finish flags turn complete. */
+    /**
+     * Add a callback to run once all the work currently queued on the
+     * specified accelerator has finished. Outside of simulation, kernels
+     * complete before they return, so the callback runs immediately.
+     */
+    void addFinishCallback(int accelIdx, std::function<void()> callback);
+
+    /**
+     * Wait until all the finish flags turn complete. The finish callbacks of
+     * each accelerator run as soon as it finishes, in completion order.
+     */
     void joinAll();
 
     /**
-     * Get the next accelerator and wait if it's still busy. A round-robin
-     * scheduling policy is used for picking the accelerator. The simple static
-     * policy is used because the scheduling decisions need to be the same as
-     * when we generate the traces, whereas dynamic decisions that depend on
-     * runtime information may lead to mismatch between the traces and the
-     * simulation.
+     * Get the next accelerator and wait if it's still busy.
+     *
+     * With the RoundRobin policy, the accelerator after currAccelIdx is
+     * picked. The simple static policy is used because the scheduling
+     * decisions need to be the same as when we generate the traces, whereas
+     * dynamic decisions that depend on runtime information may lead to
+     * mismatch between the traces and the simulation.
+     *
+     * With the FirstFinished policy, all accelerators are polled, starting
+     * from the one after currAccelIdx, until one of them is idle. The decision
+     * is recorded in (or, when replaying, read from) accelDispatchLog.
      *
      * TODO(xyzsam): the pool should be able to keep track of the current
      * accelerator index on its own.
@@ -56,11 +132,26 @@ class SmvAcceleratorPool {
     /** Wait until this accelerator's finish flags turn complete. */
     void join(int accelIdx);
 
+    /**
+     * Returns true if all the work queued on this accelerator has finished,
+     * without waiting for it. Runs the finish callbacks if so.
+     */
+    bool poll(int accelIdx);
+
+    /** Polls all accelerators until one of them has finished. */
+    int waitForAnyAccelerator(int currAccelIdx);
+
+    /** Runs the finish callbacks of this accelerator. */
+    void runFinishCallbacks(int accelIdx);
+
     /** Number of accelerators in the pool. */
     int size;
 
     /** Active finish flags for all the accelerators in the pool. */
     std::vector<std::deque<std::unique_ptr<volatile int>>> finishFlags;
+
+    /** Callbacks to run when each accelerator is joined. */
+    std::vector<std::vector<std::function<void()>>> finishCallbacks;
 };
 
 }  // namespace smaug
@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <vector>
+
+#include "catch.hpp"
+#include "smaug/core/smaug_test.h"
+#include "smaug/operators/common.h"
+#include "smaug/operators/smv/smv_accel_pool.h"
+
+using namespace smaug;
+
+class AcceleratorPoolTest : public SmaugTest {
+   public:
+    AcceleratorPoolTest() {
+        // Finish flags are only tracked in simulation.
+        runningInSimulation = true;
+        accelDispatchPolicy = FirstFinished;
+        accelDispatchLog.clear();
+    }
+
+    ~AcceleratorPoolTest() {
+        runningInSimulation = false;
+        accelDispatchPolicy = RoundRobin;
+        accelDispatchLog.clear();
+    }
+
+    // Queues a tile on the accelerator, which finishes once the returned flag
+    // is set.
+    volatile int* startTile(SmvAcceleratorPool& pool, int accelIdx) {
+        volatile int* finishFlag = new volatile int(NOT_COMPLETED);
+        pool.addFinishFlag(accelIdx, std::unique_ptr<volatile int>(finishFlag));
+        pool.addFinishCallback(
+                accelIdx, [this, accelIdx]() { finished.push_back(accelIdx); });
+        return finishFlag;
+    }
+
+   protected:
+    static constexpr int kDone = 1;
+    std::vector<int> finished;
+};
+
+TEST_CASE_METHOD(AcceleratorPoolTest,
+                 "Dispatch tiles to the first finished accelerator",
+                 "[accelpool]") {
+    SmvAcceleratorPool pool(3);
+    volatile int* flag0 = startTile(pool, 0);
+    volatile int* flag1 = startTile(pool, 1);
+    volatile int* flag2 = startTile(pool, 2);
+
+    // Round-robin would wait for accelerator 1 here.
+    *flag2 = kDone;
+    REQUIRE(pool.getNextAvailableAccelerator(0) == 2);
+    REQUIRE(finished == std::vector<int>{ 2 });
+    *flag0 = kDone;
+    REQUIRE(pool.getNextAvailableAccelerator(2) == 0);
+    REQUIRE(finished == std::vector<int>{ 2, 0 });
+    *flag1 = kDone;
+    pool.joinAll();
+    REQUIRE(finished == std::vector<int>{ 2, 0, 1 });
+    REQUIRE(accelDispatchLog.size() == 2);
+
+    SECTION("Decisions are replayed when generating traces") {
+        std::string path = "accel_dispatch_log_test.txt";
+        accelDispatchLog.save(path);
+        accelDispatchLog.clear();
+        REQUIRE(accelDispatchLog.load(path));
+        std::remove(path.c_str());
+        REQUIRE(accelDispatchLog.isReplaying());
+
+        // Outside of simulation, every accelerator is always idle.
+        runningInSimulation = false;
+        SmvAcceleratorPool tracePool(3);
+        REQUIRE(tracePool.getNextAvailableAccelerator(0) == 2);
+        REQUIRE(tracePool.getNextAvailableAccelerator(2) == 0);
+    }
+}
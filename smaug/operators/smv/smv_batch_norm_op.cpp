@@ -76,6 +76,10 @@ void SmvBatchNormOp::runNA(TiledTensor& inputs,
                          smv::spad2, inputDims, weightsShape[1],
                          inputShape.getPadding(1), actStart, sendOutputs,
                          actInfo.function, actInfo.params);
+            // The output tile is finished once all the weights for it have
+            // been applied.
+            if (inputActTiles == weightActTiles || wC == weightActTiles - 1)
+                outputs.gatherTileAsync(outputTileIdx);
 
             actOffset += weightsTile->getShape()[1];
             if (inputActTiles == weightActTiles) {
@@ -163,6 +167,10 @@ void SmvBatchNormOp::runNHWC(TiledTensor& inputs,
                                     &sampling);
                     accelPool.addFinishFlag(
                             currAccelIdx, std::move(finishFlag));
+                    accelPool.addFinishCallback(
+                            currAccelIdx, [&outputs, outputTileIdx]() {
+                                outputs.gatherTileAsync(outputTileIdx);
+                            });
                     ifmapOffset += inputShape[3];
                     currAccelIdx =
                             accelPool.getNextAvailableAccelerator(currAccelIdx);
@@ -201,8 +209,8 @@ void SmvBatchNormOp::run() {
     {
         auto stats = gem5::ScopedStats(
                 stats::kTensorPrepStart, stats::kTensorPrepEnd);
-        tiledTensors[0].copyDataToAllTiles();
-        tiledTensors[1].copyDataToAllTiles();
+        tiledTensors[0].prefetchAllTiles();
+        tiledTensors[1].prefetchAllTiles();
     }
 
     if (isPostConv) {
@@ -29,6 +29,12 @@ class SmvBatchNormOp : public BatchNormOp<SmvBackend> {
     using BatchNormOp<SmvBackend>::BatchNormOp;
     void tile() override;
     void run() override;
+    TiledTensor* getTiledInput(int index) override {
+        return index == Inputs ? &tiledTensors[0] : nullptr;
+    }
+    TiledTensor* getTiledOutput(int index) override {
+        return index == Outputs ? &tiledTensors[2] : nullptr;
+    }
 
   protected:
    /** Post-FC tile dispatcher. */
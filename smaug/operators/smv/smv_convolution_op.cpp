@@ -7,14 +7,6 @@
 #include "smaug/utility/debug_stream.h"
 
 namespace smaug {
-namespace smv {
-namespace conv {
-
-const int kNumPEs = 8;
-const int kNumMaccsPerPE = 32;
-
-}  // namespace conv
-}  // namespace smv
 
 void SmvConvolutionOp::runNHWC(TiledTensor& inputs,
                                TiledTensor& weights,
@@ -163,9 +155,32 @@ void SmvConvolutionOp::runNHWC(TiledTensor& inputs,
                         // If this is a new input/weight tile, then we need to
                         // read it.
                         bool readInputs = false;
+                        // When the inputs are tiled rowwise only, the halo rows
+                        // that the previous row tile shares with this one are
+                        // still in the scratchpad if this accelerator just read
+                        // the previous row tile. The DLA-like kernel then
+                        // slides them up and only reads the new rows.
+                        int reuseRows = 0, reuseSrcRow = 0;
                         if (inputTileIdx !=
                             lastReadInputTileIdx[currAccelIdx]) {
                             readInputs = true;
+                            if (H > 0 && inputChanTiles == 1 &&
+                                inputShape[0] == 1 &&
+                                lastReadInputTileIdx[currAccelIdx] ==
+                                        inputIdx(N, H - 1, 0, 0)) {
+                                int prevTileIdx = inputIdx(N, H - 1, 0, 0);
+                                int prevRows =
+                                        inputs[prevTileIdx]->getShape()[1];
+                                int overlap =
+                                        inputs.getTileOrigin(prevTileIdx)[1] +
+                                        prevRows -
+                                        inputs.getTileOrigin(inputTileIdx)[1];
+                                if (overlap > 0 && overlap <= prevRows &&
+                                    overlap <= inputShape[1]) {
+                                    reuseRows = overlap;
+                                    reuseSrcRow = prevRows - overlap;
+                                }
+                            }
                             lastReadInputTileIdx[currAccelIdx] = inputTileIdx;
                         }
                         bool readWeights = false;
@@ -209,11 +224,20 @@ void SmvConvolutionOp::runNHWC(TiledTensor& inputs,
                                     outputShape.getPadding(3), inputHaloPad,
                                     getRowStride(), getColStride(), ifmapStart,
                                     kernStart, accumulate, readInputs,
-                                    readWeights, sendResults, actInfo.function,
+                                    reuseRows, reuseSrcRow, readWeights,
+                                    sendResults, actInfo.function,
                                     actInfo.params, &sampling);
                         }
                         accelPool.addFinishFlag(
                                 currAccelIdx, std::move(finishFlag));
+                        // Gather the finished output tile in the background
+                        // while the next tiles are being computed.
+                        if (sendResults) {
+                            accelPool.addFinishCallback(
+                                    currAccelIdx, [&outputs, outputTileIdx]() {
+                                        outputs.gatherTileAsync(outputTileIdx);
+                                    });
+                        }
 
                         ifmapOffset += weightsTile->getShape()[3];
                         if (inputChanTiles == weightChanTiles) {
@@ -321,8 +345,8 @@ void SmvConvolutionOp::run() {
     {
         auto stats = gem5::ScopedStats(
                 stats::kTensorPrepStart, stats::kTensorPrepEnd);
-        tiledTensors[0].copyDataToAllTiles();
-        tiledTensors[1].copyDataToAllTiles();
+        tiledTensors[0].prefetchAllTiles();
+        tiledTensors[1].prefetchAllTiles();
     }
 
     runNHWC(tiledTensors[0], tiledTensors[1], tiledTensors[2]);
@@ -11,9 +11,6 @@ namespace smv {
 /** Contains convolution implementations and tiling optimizers for SMV. */
 namespace conv {
 
-extern const int kNumPEs;
-extern const int kNumMaccsPerPE;
-
 class TilingOptimizer;
 
 }  // namespace conv
@@ -29,11 +26,23 @@ class SmvConvolutionOp : public ConvolutionOp<SmvBackend> {
     using ConvolutionOp<SmvBackend>::ConvolutionOp;
     void tile() override;
     void run() override;
+    TiledTensor* getTiledInput(int index) override {
+        return index == Inputs ? &tiledTensors[0] : nullptr;
+    }
+    TiledTensor* getTiledOutput(int index) override {
+        return index == Outputs ? &tiledTensors[2] : nullptr;
+    }
+    TiledTensor* getTiledWeights() override { return &tiledTensors[1]; }
     friend class smv::conv::TilingOptimizer;
 
   protected:
    /**
     * Tiling scheduler for this operator.
+    *
+    * When the inputs are tiled rowwise only, consecutive row tiles on the
+    * same accelerator slide a window over the input rows: the halo rows that
+    * a tile shares with the previous one are kept in the scratchpad, and only
+    * the new rows are read from the host.
     */
    void runNHWC(TiledTensor& inputs,
                 TiledTensor& weights,
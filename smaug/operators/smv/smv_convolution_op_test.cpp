@@ -1,5 +1,6 @@
 #include "catch.hpp"
 #include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
 #include "smaug/core/tensor.h"
 #include "smaug/core/smaug_test.h"
 #include "smaug/operators/smv/smv_test_common.h"
@@ -340,3 +341,51 @@ TEST_CASE_METHOD(SmvConvolutionOpTest, "Stride size tests", "[smvconv]") {
         }
     }
 }
+
+TEST_CASE_METHOD(SmvConvolutionOpTest,
+                 "SMV Tiled Convolution with tile pipelining",
+                 "[smvconv]") {
+    ScopedTilePipelining pipelining;
+
+    SECTION("DimNH tiled convolution") {
+        doTest({ 1, 32, 32, 32 }, { 128, 5, 5, 32 });
+    }
+    SECTION("DimNC tiled convolution") {
+        doTest({ 1, 16, 16, 256 }, { 8, 5, 5, 256 });
+    }
+    SECTION("DimNCH tiled convolution") {
+        doTest({ 1, 32, 32, 192 }, { 32, 4, 4, 192 });
+    }
+}
+
+TEST_CASE_METHOD(SmvConvolutionOpTest,
+                 "SMV Tiled Convolution with the tiling cost model",
+                 "[smvconv]") {
+    useTilingCostModel = true;
+
+    SECTION("Smaller channelwise tiles") {
+        doTest({ 1, 8, 8, 512 }, { 256, 3, 3, 512 });
+    }
+    SECTION("Rowwise instead of channelwise input tiles") {
+        doTest({ 1, 16, 16, 96 }, { 512, 1, 1, 96 });
+    }
+
+    useTilingCostModel = false;
+}
+
+TEST_CASE_METHOD(SmvConvolutionOpTest,
+                 "SMV Tiled Convolution with sliding input rows",
+                 "[smvconv]") {
+    SECTION("Row tiles overlap by the kernel halo") {
+        doTest({ 1, 64, 16, 64 }, { 8, 3, 3, 64 });
+    }
+    SECTION("Row tiles overlap with 2x2 strides") {
+        doTest({ 1, 64, 16, 64 }, { 8, 5, 5, 64 }, ValidPadding, { 2, 2 });
+    }
+    SECTION("Row tiles don't overlap") {
+        doTest({ 1, 64, 16, 64 }, { 8, 2, 2, 64 }, ValidPadding, { 3, 3 });
+    }
+    SECTION("Weights are tiled between the row tiles") {
+        doTest({ 1, 64, 16, 64 }, { 256, 3, 3, 64 });
+    }
+}
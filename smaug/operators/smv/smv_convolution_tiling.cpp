@@ -1,9 +1,11 @@
 #include <algorithm>
 
 #include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
 #include "smaug/operators/common.h"
 #include "smaug/operators/smv/smv_convolution_op.h"
 #include "smaug/operators/smv/smv_convolution_tiling.h"
+#include "smaug/operators/smv/smv_tiling_cache.h"
 #include "smaug/utility/debug_stream.h"
 
 namespace smaug {
@@ -11,24 +13,31 @@ namespace smv {
 namespace conv {
 
 std::array<TilingDims, 3> TilingOptimizer::determineBestTilingDims(
-        Tensor* inputs, Tensor* weights, Tensor* outputs, int maxTileSize) {
+        Tensor* inputs,
+        Tensor* weights,
+        Tensor* outputs,
+        const TileSizeLimits& limits,
+        TilingDims inputTilingDims) {
     // Determine the best tiling strategy for each of inputs, weights, and
     // outputs. Don't try to figure out the actual tile sizes yet.
-    TilingDims bestInputTilingDims =
-            findBestTilingDims(inputs->getShape(),
-                               maxTileSize,
-                               { 1, weights->getShape()[1],
-                                 inputs->getShape()[2], kNumMaccsPerPE });
+    TilingDims bestInputTilingDims = inputTilingDims;
+    if (bestInputTilingDims == Invalid) {
+        bestInputTilingDims =
+                findBestTilingDims(inputs->getShape(),
+                                   limits.inputs,
+                                   { 1, weights->getShape()[1],
+                                     inputs->getShape()[2], kNumMaccsPerPE });
+    }
     TilingDims bestWeightTilingDims =
             findBestTilingDims(weights->getShape(),
-                               maxTileSize,
+                               limits.weights,
                                { kNumPEs, weights->getShape()[1],
                                  weights->getShape()[2], kNumMaccsPerPE });
     assert(bestWeightTilingDims != TilingDims::DimNH &&
            "Weights cannot be tiled by dimensions NH!");
     TilingDims bestOutputTilingDims =
             findBestTilingDims(outputs->getShape(),
-                               maxTileSize,
+                               limits.outputs,
                                { 1, 1, outputs->getShape()[2], kNumPEs });
 
     // Apply some constraints to simplify tiling logic.
@@ -58,18 +67,71 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
     Tensor* inputs = op->getInput(op->Inputs);
     Tensor* weights = op->getInput(op->Kernels);
     Tensor* outputs = op->getOutput(op->Outputs);
-    int maxTileSize = SmvBackend::SpadSize() / inputs->getDataTypeSize();
+    TileSizeLimits limits = getTileSizeLimits(inputs->getDataTypeSize());
     std::array<TilingDims, 3> strategies =
-            determineBestTilingDims(inputs, weights, outputs, maxTileSize);
+            determineBestTilingDims(inputs, weights, outputs, limits);
+    std::vector<TilingConfig> fullConfigs;
+    enumTilingConfigs(op, strategies, limits, fullConfigs);
+    // The best tiling dimensions tile as few dimensions as possible, which
+    // prefers channelwise over rowwise input tiles. Channelwise input tiles
+    // make every weight tile be reloaded for every input tile, while rowwise
+    // ones only reload the halo rows, so try both.
+    if (useTilingCostModel && strategies[0] == DimNC) {
+        enumTilingConfigs(op,
+                          determineBestTilingDims(
+                                  inputs, weights, outputs, limits, DimNH),
+                          limits,
+                          fullConfigs);
+    }
+    dout(2) << "  Number of possible tiling configs: " << fullConfigs.size()
+            << "\n";
+    for (auto& config : fullConfigs)
+        dout(2) << "    " << config << "\n";
+    std::vector<TilingConfig>::iterator bestIt;
+    if (useTilingCostModel) {
+        // Pick the config with the lowest cost. Among equally costly configs,
+        // the larger tiles win, as they do without the cost model.
+        std::vector<int64_t> costs;
+        for (auto& config : fullConfigs)
+            costs.push_back(estimateCost(op, config).getTotalCost());
+        bestIt = fullConfigs.begin();
+        for (auto it = fullConfigs.begin(); it != fullConfigs.end(); ++it) {
+            int64_t cost = costs[it - fullConfigs.begin()];
+            int64_t bestCost = costs[bestIt - fullConfigs.begin()];
+            if (cost < bestCost ||
+                (cost == bestCost &&
+                 it->getTotalSize() > bestIt->getTotalSize())) {
+                bestIt = it;
+            }
+        }
+    } else {
+        bestIt = std::max_element(
+                fullConfigs.begin(),
+                fullConfigs.end(),
+                [](const TilingConfig& c1, const TilingConfig& c2) {
+                    return c1.getTotalSize() < c2.getTotalSize();
+                });
+    }
+    assert(bestIt != fullConfigs.end() && "Failed to get best tiling config!");
+    dout(2) << "  Tiling dimensions chosen:\n"
+            << "    input: " << bestIt->inputTilingDims
+            << ", weight: " << bestIt->weightTilingDims
+            << ", output: " << bestIt->outputTilingDims << "\n";
+    return *bestIt;
+}
+
+void TilingOptimizer::enumTilingConfigs(
+        SmvConvolutionOp* op,
+        const std::array<TilingDims, 3>& strategies,
+        const TileSizeLimits& limits,
+        std::vector<TilingConfig>& fullConfigs) {
+    Tensor* inputs = op->getInput(op->Inputs);
+    Tensor* weights = op->getInput(op->Kernels);
+    Tensor* outputs = op->getOutput(op->Outputs);
     TilingDims inputTilingDims = strategies[0];
     TilingDims weightTilingDims = strategies[1];
     TilingDims outputTilingDims = strategies[2];
 
-    dout(2) << "  Tiling dimensions chosen:\n"
-            << "    input: " << inputTilingDims
-            << ", weight: " << weightTilingDims
-            << ", output: " << outputTilingDims << "\n";
-
     TensorShape inputsShape = inputs->getShape();
     TensorShape weightsShape = weights->getShape();
     TensorShape outputsShape = outputs->getShape();
@@ -90,7 +152,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
         std::vector<int> minShape = inputsShape.dims();
         minShape[0] = 1;
         enum4DTensorTilingConfigs(inputsShape,
-                                  maxTileSize,
+                                  limits.inputs,
                                   minShape,
                                   { 1, 1, 1, 1 },
                                   inputConfigs);
@@ -99,7 +161,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
         minShape[0] = 1;
         minShape[3] = kNumMaccsPerPE;
         enum4DTensorTilingConfigs(inputsShape,
-                                  maxTileSize,
+                                  limits.inputs,
                                   minShape,
                                   { 1, 1, 1, kNumMaccsPerPE },
                                   inputConfigs);
@@ -108,7 +170,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
         minShape[0] = 1;
         minShape[1] = weightsShape[1];
         enum4DTensorTilingConfigs(inputsShape,
-                                  maxTileSize,
+                                  limits.inputs,
                                   minShape,
                                   { 1, op->getRowStride(), 1, 1 },
                                   inputConfigs);
@@ -117,11 +179,10 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
                                       kNumMaccsPerPE };
         std::vector<int> strides = { 1, op->getRowStride(), 1, kNumMaccsPerPE };
         enum4DTensorTilingConfigs(
-                inputsShape, maxTileSize, minShape, strides, inputConfigs);
+                inputsShape, limits.inputs, minShape, strides, inputConfigs);
     } else {
         inputConfigs.push_back(inputsShape);
     }
-    assert(!inputConfigs.empty() && "No tiling configurations found!");
 
     // Fill in weights.
     std::list<TilingConfig> inputWeightConfigs;
@@ -134,7 +195,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
                 config.weights = weightsShape;
                 config.weights[0] = n;
                 config.weights[3] = inputsShape[3];
-                if (config.weights.storageSize() <= maxTileSize) {
+                if (config.weights.storageSize() <= limits.weights) {
                     config.inputs = inputsShape;
                     inputWeightConfigs.push_back(config);
                 } else {
@@ -152,7 +213,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
                     // If the inputs are also tiled channelwise, then the
                     // weights have to take the same channel dimension.
                     config.weights[3] = inputsShape[3];
-                    if (config.weights.storageSize() <= maxTileSize) {
+                    if (config.weights.storageSize() <= limits.weights) {
                         config.inputs = inputsShape;
                         inputWeightConfigs.push_back(config);
                     } else {
@@ -164,7 +225,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
                     for (int c = minChannels; c <= weightsShape[3];
                          c += kNumMaccsPerPE) {
                         config.weights[3] = c;
-                        if (config.weights.storageSize() <= maxTileSize) {
+                        if (config.weights.storageSize() <= limits.weights) {
                             config.inputs = inputsShape;
                             inputWeightConfigs.push_back(config);
                         } else {
@@ -188,10 +249,8 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
             inputWeightConfigs.push_back(config);
         }
     }
-    assert(!inputWeightConfigs.empty() && "No tiling configurations found!");
 
     // Fill in outputs.
-    std::vector<TilingConfig> fullConfigs;
     for (auto it = inputWeightConfigs.begin(); it != inputWeightConfigs.end();
          ++it) {
         int minChannels = std::min(it->weights[0], kNumPEs);
@@ -219,7 +278,10 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
                 else if (outputTilingDims != None)
                     config.outputs[3] = c;
             }
-            if (config.outputs.storageSize() <= maxTileSize) {
+            if (config.outputs.storageSize() <= limits.outputs) {
+                config.inputTilingDims = inputTilingDims;
+                config.weightTilingDims = weightTilingDims;
+                config.outputTilingDims = outputTilingDims;
                 fullConfigs.push_back(config);
             }
             // This means the output shape is uniquely determined, so we don't
@@ -228,22 +290,64 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvConvolutionOp* op) {
                 break;
         }
     }
-    dout(2) << "  Number of possible tiling configs: " << fullConfigs.size()
-            << "\n";
-    for (auto& config : fullConfigs)
-        dout(2) << "    " << config << "\n";
-    auto maxIt = std::max_element(
-            fullConfigs.begin(),
-            fullConfigs.end(),
-            [](const TilingConfig& c1, const TilingConfig& c2) {
-                return c1.getTotalSize() < c2.getTotalSize();
-            });
-    assert(maxIt != fullConfigs.end() && "Failed to get best tiling config!");
-    // Fill in the tiling dims.
-    (*maxIt).inputTilingDims = inputTilingDims;
-    (*maxIt).weightTilingDims = weightTilingDims;
-    (*maxIt).outputTilingDims = outputTilingDims;
-    return *maxIt;
+}
+
+TilingCost TilingOptimizer::estimateCost(SmvConvolutionOp* op,
+                                         const TilingConfig& config) {
+    const TensorShape& inputsShape = op->getInput(op->Inputs)->getShape();
+    const TensorShape& weightsShape = op->getInput(op->Kernels)->getShape();
+    const TensorShape& outputsShape = op->getOutput(op->Outputs)->getShape();
+    // Rowwise input tiles overlap by the halo rows of the filter.
+    std::vector<int> inputRowTiles;
+    int halo = op->getWeightRows() - op->getRowStride();
+    for (int remaining = inputsShape[1]; remaining > 0;) {
+        int rows = std::min(config.inputs[1], remaining);
+        inputRowTiles.push_back(rows);
+        remaining -= rows;
+        if (remaining > 0)
+            remaining += halo;
+    }
+    int inputBatchTiles = FRAC_CEIL(inputsShape[0], config.inputs[0]);
+    int inputChanTiles = FRAC_CEIL(inputsShape[3], config.inputs[3]);
+    int weightOfmapTiles = FRAC_CEIL(weightsShape[0], config.weights[0]);
+    int weightChanTiles = FRAC_CEIL(weightsShape[3], config.weights[3]);
+    int outputChanTiles = FRAC_CEIL(outputsShape[3], config.outputs[3]);
+    // These mirror the loops of runNHWC(): for every batch and row tile of
+    // the inputs, every weight tile is run against the input channel tiles,
+    // once per output channel tile that the weight tile produces.
+    int numOutputInvocations =
+            weightOfmapTiles < outputChanTiles ? outputChanTiles : 1;
+    int numChanInvocations = std::max(inputChanTiles, weightChanTiles);
+    int numInvocationsPerRowTile =
+            weightOfmapTiles * numOutputInvocations * numChanInvocations;
+    int numRowTiles = inputBatchTiles * inputRowTiles.size();
+
+    TilingCost cost;
+    cost.numInvocations = numRowTiles * numInvocationsPerRowTile;
+    cost.numInputTiles = numRowTiles * inputChanTiles;
+    cost.numWeightTiles = weightOfmapTiles * weightChanTiles;
+    cost.numOutputTiles = numRowTiles * outputChanTiles;
+    // Unless the inputs are tiled channelwise, the same input tile is used
+    // for all the invocations of a row tile, so it is read once. Otherwise,
+    // every invocation reads the next channel tile.
+    int inputReads = inputChanTiles > 1
+                             ? weightOfmapTiles * numOutputInvocations
+                             : 1;
+    int64_t inputSizePerRow = inputsShape.storageSize() / inputsShape[1];
+    for (int rows : inputRowTiles)
+        cost.inputTraffic += inputSizePerRow * rows * inputReads;
+    // With a single weight tile, it is read once and stays in the scratchpad.
+    // With channelwise weight tiles, every invocation reads the next one.
+    // Otherwise, the weights are read once for every row tile.
+    int64_t weightsSize = weightsShape.storageSize();
+    if (weightChanTiles > 1)
+        cost.weightTraffic = weightsSize * numOutputInvocations * numRowTiles;
+    else if (weightOfmapTiles > 1)
+        cost.weightTraffic = weightsSize * numRowTiles;
+    else
+        cost.weightTraffic = weightsSize;
+    cost.outputTraffic = outputsShape.storageSize();
+    return cost;
 }
 
 TiledTensor TilingOptimizer::generateRowwiseOutputTiledTensor(
@@ -321,9 +425,15 @@ TiledTensor TilingOptimizer::generateRowwiseOutputTiledTensor(
                                            outputTensor->getName() +
                                            "/tile:" + std::to_string((int)oi);
                     Tensor* outputTile = new Tensor(tileName, outputTileShape);
-                    outputTile->allocateStorage(outputTensor->getDataType());
-                    outputTiledTensor.setTile(
-                            oi, currentOrigin, outputTile, copyData);
+                    if (!outputTiledTensor.setTileView(
+                                oi, currentOrigin, outputTile)) {
+                        outputTile->setAllocator(
+                                op->getWorkspace()->getPool());
+                        outputTile->allocateStorage(
+                                outputTensor->getDataType());
+                        outputTiledTensor.setTile(
+                                oi, currentOrigin, outputTile, copyData);
+                    }
                     for (int i = ndims - 1; i >= 0; i--) {
                         currentOrigin[i] += outputTileShape[i];
                         if (currentOrigin[i] >= outputShape[i])
@@ -346,7 +456,10 @@ std::array<TiledTensor, 3> TilingOptimizer::doTiling(SmvConvolutionOp* op) {
     auto input = op->getInput(SmvConvolutionOp::Inputs);
     auto kernels = op->getInput(SmvConvolutionOp::Kernels);
     auto output = op->getOutput(SmvConvolutionOp::Outputs);
-    TilingConfig tileConfig = TilingOptimizer::computeBasicTileShapes(op);
+    TilingConfig tileConfig = tilingPlanCache.getOrCompute(
+            op,
+            { op->getRowStride(), op->getColStride(), op->getPadding() },
+            [op]() { return TilingOptimizer::computeBasicTileShapes(op); });
     TiledTensor tiledInputs =
             generateTiledTensorWithStrideAndPadding(input,
                                                     tileConfig.inputs,
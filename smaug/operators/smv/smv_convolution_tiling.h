@@ -31,14 +31,18 @@ class TilingOptimizer : public TilingOptimizerBase {
      * shapes defines a TilingConfig. The TilingConfig that maximizes the total
      * combined size of input, weights, and output tiles is chosen as the best.
      *
+     * With useTilingCostModel, the TilingConfig with the lowest estimated cost
+     * (see estimateCost()) is chosen instead, and inputs that can be tiled
+     * either channelwise or rowwise are tried both ways.
+     *
      * To limit the number of possibilities, we only enumerate each dimension
      * in certain increments. For example, input channels are only enumerated
      * in multiples of kNumMaccsPerPE, and output channels are only enumerated
      * in multiples in kNumPEs.
      *
-     * This algorithm assumes that the maximum tile size for weights, inputs,
-     * and outputs are all the same and that they will reside in separate
-     * scratchpads (no sharing).
+     * Inputs, weights, and outputs reside in separate scratchpads (no
+     * sharing), so each of their tiles must fit in its own scratchpad (see
+     * TileSizeLimits).
      *
      * @param op The SMV convolution operator. All tensors must have been
      * created with createAllTensors() prior to calling this function.
@@ -46,6 +50,19 @@ class TilingOptimizer : public TilingOptimizerBase {
      */
     static TilingConfig computeBasicTileShapes(SmvConvolutionOp* op);
 
+    /**
+     * Estimates the cost of running this convolution layer with the given
+     * TilingConfig, following the loop nest of SmvConvolutionOp::runNHWC().
+     *
+     * An input tile is reloaded whenever the previous invocation read a
+     * different one, and so is a weight tile (see the readInputs and
+     * readWeights kernel arguments). Partial sums are accumulated in the
+     * scratchpad, so every output element is written once. This assumes a
+     * single accelerator.
+     */
+    static TilingCost estimateCost(SmvConvolutionOp* op,
+                                   const TilingConfig& config);
+
     /**
      * A specialized output tiling function when the output is tiled rowwise.
      *
@@ -68,13 +85,27 @@ class TilingOptimizer : public TilingOptimizerBase {
      * dimensions, in that certain combinations of input/weight/output tiling
      * dimensions are not allowed in the interest of tiling code complexity.
      *
+     * @param inputTilingDims If not Invalid, the inputs are tiled along these
+     * dimensions instead of the best ones.
      * @returns A 3-element array of TilingDims enums (inputs, weights,
      * outputs).
      */
-    static std::array<TilingDims, 3> determineBestTilingDims(Tensor* inputs,
-                                                             Tensor* weights,
-                                                             Tensor* outputs,
-                                                             int maxTileSize);
+    static std::array<TilingDims, 3> determineBestTilingDims(
+            Tensor* inputs,
+            Tensor* weights,
+            Tensor* outputs,
+            const TileSizeLimits& limits,
+            TilingDims inputTilingDims = Invalid);
+
+    /**
+     * Enumerates the basic tile shapes that fit in the scratchpads for the
+     * given tiling dimensions of inputs, weights, and outputs, and adds them
+     * to configs.
+     */
+    static void enumTilingConfigs(SmvConvolutionOp* op,
+                                  const std::array<TilingDims, 3>& strategies,
+                                  const TileSizeLimits& limits,
+                                  std::vector<TilingConfig>& configs);
 };
 
 }  // namespace conv
@@ -1,5 +1,6 @@
 #include "catch.hpp"
 #include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
 #include "smaug/core/smaug_test.h"
 #include "smaug/core/tensor.h"
 #include "smaug/operators/smv/smv_convolution_op.h"
@@ -846,3 +847,82 @@ TEST_CASE_METHOD(SmaugTest, "Stride size tests", "[smvtiling]") {
         }
     }
 }
+
+TEST_CASE_METHOD(SmaugTest, "Tiling cost model", "[smvtiling]") {
+    using namespace smaug::smv;
+    using namespace smaug::smv::conv;
+    auto convOp = new SmvConvolutionOp("conv", workspace());
+    convOp->setStride(1, 1);
+    convOp->setPadding(SamePadding);
+    auto computeTileShapes = [convOp](bool costModel) {
+        useTilingCostModel = costModel;
+        TilingConfig config = TilingOptimizer::computeBasicTileShapes(convOp);
+        useTilingCostModel = false;
+        return config;
+    };
+
+    SECTION("Smaller channelwise tiles reload less input data") {
+        // The largest tiles reload every input tile for each of the 32 weight
+        // tiles.
+        TensorShape inputShape(
+                { 1, 8, 8, 512 }, DataLayout::NHWC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("inputs", inputShape);
+        workspace()->addTensor(inputs);
+        convOp->setInput(inputs, 0);
+        convOp->setWeightDims(3, 3, 256);
+        convOp->createAllTensors();
+        allocateAllTensors<float16>(convOp);
+        TilingConfig filled = computeTileShapes(false);
+        REQUIRE(filled.inputs.dims() == std::vector<int>{ 1, 8, 8, 224 });
+        REQUIRE(filled.weights.dims() == std::vector<int>{ 8, 3, 3, 224 });
+        TilingConfig config = computeTileShapes(true);
+        REQUIRE(config.inputs.dims() == std::vector<int>{ 1, 8, 8, 32 });
+        REQUIRE(config.weights.dims() == std::vector<int>{ 56, 3, 3, 32 });
+        REQUIRE(config.outputs.dims() == std::vector<int>{ 1, 8, 8, 56 });
+
+        TilingCost filledCost = TilingOptimizer::estimateCost(convOp, filled);
+        TilingCost cost = TilingOptimizer::estimateCost(convOp, config);
+        REQUIRE(filledCost.inputTraffic == 1048576);
+        REQUIRE(cost.inputTraffic == 163840);
+        REQUIRE(cost.weightTraffic == filledCost.weightTraffic);
+        REQUIRE(cost.numInvocations == 80);
+    }
+
+    SECTION("Rowwise input tiles instead of channelwise ones") {
+        TensorShape inputShape(
+                { 1, 16, 16, 96 }, DataLayout::NHWC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("inputs", inputShape);
+        workspace()->addTensor(inputs);
+        convOp->setInput(inputs, 0);
+        convOp->setWeightDims(1, 1, 512);
+        convOp->createAllTensors();
+        allocateAllTensors<float16>(convOp);
+        TilingConfig filled = computeTileShapes(false);
+        REQUIRE(filled.inputTilingDims == DimNC);
+        TilingConfig config = computeTileShapes(true);
+        REQUIRE(config.inputTilingDims == DimNH);
+        REQUIRE(config.weightTilingDims == DimN);
+        REQUIRE(config.outputTilingDims == DimNCH);
+        REQUIRE(config.inputs.dims() == std::vector<int>{ 1, 8, 16, 96 });
+        REQUIRE(config.weights.dims() == std::vector<int>{ 128, 1, 1, 96 });
+        REQUIRE(config.outputs.dims() == std::vector<int>{ 1, 8, 16, 128 });
+        REQUIRE(TilingOptimizer::estimateCost(convOp, config).getTotalCost() <
+                TilingOptimizer::estimateCost(convOp, filled).getTotalCost());
+    }
+
+    SECTION("The largest tiles are kept when they cost the least") {
+        TensorShape inputShape(
+                { 1, 32, 32, 64 }, DataLayout::NHWC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("inputs", inputShape);
+        workspace()->addTensor(inputs);
+        convOp->setInput(inputs, 0);
+        convOp->setWeightDims(3, 3, 128);
+        convOp->createAllTensors();
+        allocateAllTensors<float16>(convOp);
+        TilingConfig filled = computeTileShapes(false);
+        TilingConfig config = computeTileShapes(true);
+        REQUIRE(config.inputs == filled.inputs);
+        REQUIRE(config.weights == filled.weights);
+        REQUIRE(config.outputs == filled.outputs);
+    }
+}
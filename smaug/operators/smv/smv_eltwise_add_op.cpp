@@ -76,8 +76,8 @@ void SmvEltwiseAddOp::run() {
     {
         auto stats = gem5::ScopedStats(
                 stats::kTensorPrepStart, stats::kTensorPrepEnd);
-        tiledTensors[0].copyDataToAllTiles();
-        tiledTensors[1].copyDataToAllTiles();
+        tiledTensors[0].prefetchAllTiles();
+        tiledTensors[1].prefetchAllTiles();
     }
 
     runX(tiledTensors[0], tiledTensors[1], tiledTensors[2]);
@@ -75,8 +75,8 @@ void SmvEltwiseMulOp::run() {
     {
         auto stats = gem5::ScopedStats(
                 stats::kTensorPrepStart, stats::kTensorPrepEnd);
-        tiledTensors[0].copyDataToAllTiles();
-        tiledTensors[1].copyDataToAllTiles();
+        tiledTensors[0].prefetchAllTiles();
+        tiledTensors[1].prefetchAllTiles();
     }
 
     runX(tiledTensors[0], tiledTensors[1], tiledTensors[2]);
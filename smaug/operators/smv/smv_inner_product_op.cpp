@@ -7,14 +7,6 @@
 #include "smaug/utility/debug_stream.h"
 
 namespace smaug {
-namespace smv {
-namespace fc {
-
-const int kNumPEs = 8;
-const int kNumMaccsPerPE = 32;
-
-}  // namespace fc
-}  // namespace smv
 
 // This function iterates the tiles generated by the tiling optimizer and send a
 // tile triplet to the hardware kernel for computation. The tile iteration is in
@@ -22,18 +14,22 @@ const int kNumMaccsPerPE = 32;
 // 1) N: batch-wise tiles in the inputs.
 // 2) W: neuron-wise tiles in the weights.
 // 3) A: activation-wise tiles in the inputs/weights.
+//
+// If the outputs are tiled, every weight neuron-wise tile produces its own
+// output tile (the tiling optimizer makes sure they have the same neurons), so
+// the W iterations don't share any results and are spread across the
+// accelerators.
 void SmvInnerProductOp::runNWA(TiledTensor& inputs,
                                TiledTensor& weights,
                                TiledTensor& outputs) {
-    // Ordinarily, we don't need to tile the outputs. If this fails, it means
-    // the inner product has uncommonly large outputs, let's add the output
-    // iteration when that happens.
-    assert(outputs.size() == 1 &&
-           "Inner product outputs tiling not implemented yet!");
     int inputNumTiles = inputs.getShape()[0];
     int inputActTiles = inputs.getShape()[1];
     int weightActTiles = weights.getShape()[1];
     int weightNeuronTiles = weights.getShape()[0];
+    int outputNeuronTiles = outputs.getShape()[1];
+    assert((outputNeuronTiles == 1 || outputNeuronTiles == weightNeuronTiles) &&
+           "The output tiles must match the weight neuron-wise tiles!");
+    bool outputsTiled = outputNeuronTiles > 1;
     auto inputIdx = inputs.startIndex();
     auto weightIdx = weights.startIndex();
     auto outputIdx = outputs.startIndex();
@@ -59,7 +55,7 @@ void SmvInnerProductOp::runNWA(TiledTensor& inputs,
             // loop nests beyond this level will need to run in serial, because
             // the input/weight channelwise tiles iteration accumulate results
             // to the same output tile.
-            int outputTileIdx = outputIdx(N, 0);
+            int outputTileIdx = outputIdx(N, outputsTiled ? W : 0);
             Tensor* outputTile = outputs[outputTileIdx];
             const TensorShape& outputShape = outputTile->getShape();
             mapArrayToAccel(smv::kInnerProductHw + currAccelIdx, "host_results",
@@ -109,10 +105,11 @@ void SmvInnerProductOp::runNWA(TiledTensor& inputs,
                     lastReadInputTileIdx[currAccelIdx] = inputTileIdx;
                 }
                 // We only need to send the results back to host memory in the
-                // very last invocation.
-                bool sendOutputs = (N == inputNumTiles - 1) &&
-                                   (W == weightNeuronTiles - 1) &&
-                                   (wC == weightActTiles - 1);
+                // very last invocation for the output tile.
+                bool sendOutputs = (wC == weightActTiles - 1) &&
+                                   (outputsTiled ||
+                                    ((N == inputNumTiles - 1) &&
+                                     (W == weightNeuronTiles - 1)));
 
                 std::unique_ptr<volatile int> finishFlag = invokeKernelNoBlock(
                         currAccelIdx, smv::kInnerProductHw + currAccelIdx,
@@ -126,6 +123,14 @@ void SmvInnerProductOp::runNWA(TiledTensor& inputs,
                         accumulate, readInputs, sendOutputs, actInfo.function,
                         actInfo.params, &sampling);
                 accelPool.addFinishFlag(currAccelIdx, std::move(finishFlag));
+                // Gather the finished output tile in the background while the
+                // next tiles are being computed.
+                if (sendOutputs) {
+                    accelPool.addFinishCallback(
+                            currAccelIdx, [&outputs, outputTileIdx]() {
+                                outputs.gatherTileAsync(outputTileIdx);
+                            });
+                }
 
                 actOffset += weightsTile->getShape()[1];
                 if (inputActTiles == weightActTiles) {
@@ -139,7 +144,8 @@ void SmvInnerProductOp::runNWA(TiledTensor& inputs,
                                     "don't need activation-wise tiling.");
                 }
             }
-            finishedNeurons += weights[weightIdx(W, 0)]->getShape()[0];
+            if (!outputsTiled)
+                finishedNeurons += weights[weightIdx(W, 0)]->getShape()[0];
             currAccelIdx = accelPool.getNextAvailableAccelerator(currAccelIdx);
         }
     }
@@ -169,8 +175,8 @@ void SmvInnerProductOp::run() {
     {
         auto stats = gem5::ScopedStats(
                 stats::kTensorPrepStart, stats::kTensorPrepEnd);
-        tiledTensors[0].copyDataToAllTiles();
-        tiledTensors[1].copyDataToAllTiles();
+        tiledTensors[0].prefetchAllTiles();
+        tiledTensors[1].prefetchAllTiles();
     }
 
     runNWA(tiledTensors[0], tiledTensors[1], tiledTensors[2]);
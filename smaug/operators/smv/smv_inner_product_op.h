@@ -12,9 +12,6 @@ namespace smv {
 /** Contains implementations of inner product on SMV and related functions. */
 namespace fc {
 
-extern const int kNumPEs;
-extern const int kNumMaccsPerPE;
-
 class TilingOptimizer;
 
 }  // namespace fc
@@ -30,6 +27,7 @@ class SmvInnerProductOp : public InnerProductOp<SmvBackend> {
     using InnerProductOp<SmvBackend>::InnerProductOp;
     void tile() override;
     void run() override;
+    TiledTensor* getTiledWeights() override { return &tiledTensors[1]; }
     friend class smv::fc::TilingOptimizer;
 
   protected:
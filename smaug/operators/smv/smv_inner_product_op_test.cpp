@@ -98,6 +98,21 @@ TEST_CASE_METHOD(SmvInnerProductOpTest, "SMV tiled inner product", "[smvfc]") {
         // also tiled into 32 neuron-wise tiles.
         doTest({ 1, 32768 }, 256);
     }
+
+    SECTION("DimN tiling for weights, DimNC for outputs") {
+        // Weights and outputs are tiled into 79 neuron-wise tiles.
+        doTest({ 1, 64 }, 20000);
+    }
+
+    SECTION("Output tiles spread across accelerators") {
+        numAcceleratorsAvailable = 2;
+        doTest({ 1, 64 }, 20000);
+    }
+
+    SECTION("Outputs need tiling but weights don't") {
+        // Weights and outputs are tiled into 2 neuron-wise tiles.
+        doTest({ 64, 32 }, 512);
+    }
 }
 
 TEST_CASE_METHOD(SmvInnerProductOpTest,
@@ -4,6 +4,7 @@
 #include "smaug/operators/common.h"
 #include "smaug/operators/smv/smv_inner_product_op.h"
 #include "smaug/operators/smv/smv_inner_product_tiling.h"
+#include "smaug/operators/smv/smv_tiling_cache.h"
 #include "smaug/utility/debug_stream.h"
 
 namespace smaug {
@@ -11,18 +12,25 @@ namespace smv {
 namespace fc {
 
 std::array<TilingDims, 3> TilingOptimizer::determineBestTilingDims(
-        Tensor* inputs, Tensor* weights, Tensor* outputs, int maxTileSize) {
+        Tensor* inputs,
+        Tensor* weights,
+        Tensor* outputs,
+        const TileSizeLimits& limits) {
     // Determine the best tiling strategy for each of inputs, weights, and
     // outputs. Don't try to figure out the actual tile sizes yet.
     TilingDims bestInputTilingDims = findBestTilingDims(
-            inputs->getShape(), maxTileSize, { 1, kNumMaccsPerPE });
+            inputs->getShape(), limits.inputs, { 1, kNumMaccsPerPE });
     TilingDims bestWeightTilingDims = findBestTilingDims(
-            weights->getShape(), maxTileSize, { kNumPEs, kNumMaccsPerPE });
+            weights->getShape(), limits.weights, { kNumPEs, kNumMaccsPerPE });
     TilingDims bestOutputTilingDims = findBestTilingDims(
-            outputs->getShape(), maxTileSize, { 1, kNumPEs });
+            outputs->getShape(), limits.outputs, { 1, kNumPEs });
 
     // Apply some constraints to simplify tiling logic.
     //
+    // If outputs require tiling, then weights must be tiled on neurons, so
+    // that every weight tile produces exactly one output tile.
+    if (bestOutputTilingDims != None && bestWeightTilingDims == None)
+        bestWeightTilingDims = DimN;
     // If weights require tiling on neurons, then outputs must be DimNC (if
     // outputs require tiling), so that we will copy out C neurons of outputs
     // after every tile.
@@ -36,9 +44,9 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvInnerProductOp* op) {
     Tensor* inputs = op->getInput(op->Inputs);
     Tensor* weights = op->getInput(op->Weights);
     Tensor* outputs = op->getOutput(op->Outputs);
-    int maxTileSize = SmvBackend::SpadSize() / inputs->getDataTypeSize();
+    TileSizeLimits limits = getTileSizeLimits(inputs->getDataTypeSize());
     std::array<TilingDims, 3> strategies =
-            determineBestTilingDims(inputs, weights, outputs, maxTileSize);
+            determineBestTilingDims(inputs, weights, outputs, limits);
     TilingDims inputTilingDims = strategies[0];
     TilingDims weightTilingDims = strategies[1];
     TilingDims outputTilingDims = strategies[2];
@@ -58,22 +66,21 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvInnerProductOp* op) {
     // 1. Start with inputs. Enumerate all shapes that fit.
     // 2. Move on to weights. Enumerate all shapes that are compatible with
     //    the input shape and fit.
-    // 3. Move on to outputs. If the weights don't need tiling, the outputs
-    //    can be tiled independently; otherwise, based on the input and weights
-    //    tile shapes, the output tile shape is completely determined.
+    // 3. Move on to outputs. Based on the input and weights tile shapes, the
+    //    output tile shape is completely determined.
     // For all tiling strategy, compute the total SRAM utilization. The highest
     // one is the chosen one.
     std::vector<TensorShape> inputConfigs;
     if (inputTilingDims == DimN) {
         enum2DTensorTilingConfigs(inputsShape,
-                                  maxTileSize,
+                                  limits.inputs,
                                   { 1, inputsShape[1] },
                                   { 1, 1 },
                                   inputConfigs);
     } else if (inputTilingDims == DimNC) {
         std::vector<int> minShape = inputsShape.dims();
         enum2DTensorTilingConfigs(inputsShape,
-                                  maxTileSize,
+                                  limits.inputs,
                                   { 1, kNumMaccsPerPE },
                                   { 1, kNumMaccsPerPE },
                                   inputConfigs);
@@ -94,7 +101,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvInnerProductOp* op) {
                 config.weights = TensorShape({ n, inputsShape[1] },
                                              inputsShape.getLayout(),
                                              SmvBackend::Alignment);
-                if (config.weights.storageSize() <= maxTileSize) {
+                if (config.weights.storageSize() <= limits.weights) {
                     config.inputs = inputsShape;
                     inputWeightConfigs.push_back(config);
                 } else {
@@ -112,7 +119,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvInnerProductOp* op) {
                     // If the inputs are also tiled activation-wise, then the
                     // weights have to take the same activations dimension.
                     config.weights[1] = inputsShape[1];
-                    if (config.weights.storageSize() <= maxTileSize) {
+                    if (config.weights.storageSize() <= limits.weights) {
                         config.inputs = inputsShape;
                         inputWeightConfigs.push_back(config);
                     } else {
@@ -124,7 +131,7 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvInnerProductOp* op) {
                     for (int c = minActs; c <= weightsShape[1];
                          c += kNumMaccsPerPE) {
                         config.weights[1] = c;
-                        if (config.weights.storageSize() <= maxTileSize) {
+                        if (config.weights.storageSize() <= limits.weights) {
                             config.inputs = inputsShape;
                             inputWeightConfigs.push_back(config);
                         } else {
@@ -152,30 +159,14 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvInnerProductOp* op) {
     std::vector<TilingConfig> fullConfigs;
     for (auto it = inputWeightConfigs.begin(); it != inputWeightConfigs.end();
          ++it) {
-        int minChannels = std::min(it->weights[0], kNumPEs);
-        bool weightsNeedTiling = (weightTilingDims != None);
-        bool outputsNeedTiling = (outputTilingDims != None);
-        for (int c = minChannels; c <= weightsShape[0]; c += kNumPEs) {
-            TilingConfig config = *it;
-            config.outputs = outputsShape;
-            config.outputs[0] = config.inputs[0];
-            if (weightsNeedTiling && outputsNeedTiling) {
-                config.outputs[1] = config.weights[0];
-            } else if (outputsNeedTiling) {
-                // This could rarely happen, but for completeness let's keep it.
-                // If the weights don't need tiling and the outputs need tiling,
-                // the channel size of the output tile size can be determined
-                // independently.
-                config.outputs[1] = c;
-            }
-            if (config.outputs.storageSize() <= maxTileSize) {
-                fullConfigs.push_back(config);
-            }
-            // This means the output shape is uniquely determined, so we don't
-            // need to explore any other output channel values.
-            if (weightsNeedTiling || outputTilingDims == None)
-                break;
-        }
+        TilingConfig config = *it;
+        config.outputs = outputsShape;
+        config.outputs[0] = config.inputs[0];
+        // The outputs are tiled only along with the weight neurons.
+        if (outputTilingDims != None)
+            config.outputs[1] = config.weights[0];
+        if (config.outputs.storageSize() <= limits.outputs)
+            fullConfigs.push_back(config);
     }
     dout(2) << "  Number of possible tiling configs: " << fullConfigs.size()
             << "\n";
@@ -195,11 +186,38 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvInnerProductOp* op) {
     return *maxIt;
 }
 
+TilingCost TilingOptimizer::estimateCost(SmvInnerProductOp* op,
+                                         const TilingConfig& config) {
+    const TensorShape& inputsShape = op->getInput(op->Inputs)->getShape();
+    const TensorShape& weightsShape = op->getInput(op->Weights)->getShape();
+    const TensorShape& outputsShape = op->getOutput(op->Outputs)->getShape();
+    int inputBatchTiles = FRAC_CEIL(inputsShape[0], config.inputs[0]);
+    int inputActTiles = FRAC_CEIL(inputsShape[1], config.inputs[1]);
+    int weightNeuronTiles = FRAC_CEIL(weightsShape[0], config.weights[0]);
+    int weightActTiles = FRAC_CEIL(weightsShape[1], config.weights[1]);
+    int outputNeuronTiles = FRAC_CEIL(outputsShape[1], config.outputs[1]);
+
+    TilingCost cost;
+    cost.numInvocations = inputBatchTiles * weightNeuronTiles *
+                          std::max(inputActTiles, weightActTiles);
+    cost.numInputTiles = inputBatchTiles * inputActTiles;
+    cost.numWeightTiles = weightNeuronTiles * weightActTiles;
+    cost.numOutputTiles = inputBatchTiles * outputNeuronTiles;
+    int64_t inputsSize = inputsShape.storageSize();
+    cost.inputTraffic =
+            inputActTiles > 1 ? inputsSize * weightNeuronTiles : inputsSize;
+    cost.weightTraffic = (int64_t)weightsShape.storageSize() * inputBatchTiles;
+    cost.outputTraffic = outputsShape.storageSize();
+    return cost;
+}
+
 std::array<TiledTensor, 3> TilingOptimizer::doTiling(SmvInnerProductOp* op) {
     auto input = op->getInput(SmvInnerProductOp::Inputs);
     auto kernels = op->getInput(SmvInnerProductOp::Weights);
     auto output = op->getOutput(SmvInnerProductOp::Outputs);
-    TilingConfig tileConfig = TilingOptimizer::computeBasicTileShapes(op);
+    TilingConfig tileConfig = tilingPlanCache.getOrCompute(op, {}, [op]() {
+        return TilingOptimizer::computeBasicTileShapes(op);
+    });
     TiledTensor tiledInputs =
             generateTiledTensor(input, tileConfig.inputs, op, /* copy_data*/ false);
     // Copy data for the weight tiles since the data is read-only.
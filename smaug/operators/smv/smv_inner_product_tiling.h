@@ -36,9 +36,9 @@ class TilingOptimizer : public TilingOptimizerBase {
      * in multiples of kNumMaccsPerPE, and output channels are only enumerated
      * in multiples in kNumPEs.
      *
-     * This algorithm assumes that the maximum tile size for weights, inputs,
-     * and outputs are all the same and that they will reside in separate
-     * scratchpads (no sharing).
+     * Inputs, weights, and outputs reside in separate scratchpads (no
+     * sharing), so each of their tiles must fit in its own scratchpad (see
+     * TileSizeLimits).
      *
      * @param op The SMV inner product operator. All tensors must have been
      * created with createAllTensors() prior to calling this function.
@@ -46,6 +46,18 @@ class TilingOptimizer : public TilingOptimizerBase {
      */
     static TilingConfig computeBasicTileShapes(SmvInnerProductOp* op);
 
+    /**
+     * Estimates the cost of running this inner product layer with the given
+     * TilingConfig, following the loop nest of SmvInnerProductOp::runNWA().
+     *
+     * The weights are read for every batch tile, and the inputs once per
+     * batch tile unless they are tiled on activations, in which case they are
+     * read for every weight neuron-wise tile. This assumes a single
+     * accelerator.
+     */
+    static TilingCost estimateCost(SmvInnerProductOp* op,
+                                   const TilingConfig& config);
+
    protected:
     /**
      * Determine the best tiling dimensions for running inner product on SMV.
@@ -57,10 +69,11 @@ class TilingOptimizer : public TilingOptimizerBase {
      * @returns A 3-element array of TilingDims enums (inputs, weights,
      * outputs).
      */
-    static std::array<TilingDims, 3> determineBestTilingDims(Tensor* inputs,
-                                                             Tensor* weights,
-                                                             Tensor* outputs,
-                                                             int maxTileSize);
+    static std::array<TilingDims, 3> determineBestTilingDims(
+            Tensor* inputs,
+            Tensor* weights,
+            Tensor* outputs,
+            const TileSizeLimits& limits);
 };
 
 }  // namespace fc
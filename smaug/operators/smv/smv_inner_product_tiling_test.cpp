@@ -161,4 +161,49 @@ TEST_CASE_METHOD(SmaugTest, "Basic tiling tests", "[smvtiling]") {
             verifyTensorWithFixedData(outputTiles[0], 0);
         }
     }
+
+    SECTION("DimN tiling for weights, DimNC for outputs") {
+        TensorShape inputShape(
+                { 1, 64 }, DataLayout::NC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("inputs", inputShape);
+        workspace()->addTensor(inputs);
+        fcOp->setInput(inputs, 0);
+        // The outputs can't fit either, so every weight neuron-wise tile
+        // produces one output tile.
+        fcOp->setNumOutputs(20000);
+        fcOp->createAllTensors();
+        allocateAllTensors<float16>(fcOp);
+        TilingConfig config = TilingOptimizer::computeBasicTileShapes(fcOp);
+        REQUIRE(config.inputs == inputShape);
+        REQUIRE(config.weights.dims() == std::vector<int>{ 256, 64 });
+        REQUIRE(config.outputs.dims() == std::vector<int>{ 1, 256 });
+
+        SECTION("Generated tiles have correct shape") {
+            TiledTensor weightTiles = generateTiledTensor(
+                    fcOp->getInput(1), config.weights, fcOp);
+            TiledTensor outputTiles = generateTiledTensor(
+                    fcOp->getOutput(0), config.outputs, fcOp);
+            REQUIRE(weightTiles.size() == 79);
+            REQUIRE(outputTiles.size() == 79);
+            REQUIRE(outputTiles[78]->getShape().dims() ==
+                    std::vector<int>{ 1, 32 });
+        }
+    }
+
+    SECTION("Outputs need tiling but weights don't") {
+        TensorShape inputShape(
+                { 64, 32 }, DataLayout::NC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("inputs", inputShape);
+        workspace()->addTensor(inputs);
+        fcOp->setInput(inputs, 0);
+        // The weights can all fit, but the outputs of the whole batch can't.
+        // The weights are then tiled neuron-wise along with the outputs.
+        fcOp->setNumOutputs(512);
+        fcOp->createAllTensors();
+        allocateAllTensors<float16>(fcOp);
+        TilingConfig config = TilingOptimizer::computeBasicTileShapes(fcOp);
+        REQUIRE(config.inputs == inputShape);
+        REQUIRE(config.weights.dims() == std::vector<int>{ 256, 32 });
+        REQUIRE(config.outputs.dims() == std::vector<int>{ 64, 256 });
+    }
 }
@@ -26,6 +26,8 @@ void smv_conv3d_nhwc_vec_fxp(float16* host_inputs,
                              int kern_start,
                              bool accumulate,
                              bool read_inputs,
+                             int reuse_rows,
+                             int reuse_src_row,
                              bool read_weights,
                              bool send_results,
                              activation_type act_function,
@@ -142,6 +144,18 @@ void smv_softmax_nc_vec_fxp(float16* host_inputs,
                             int input_size,
                             int input_pad);
 
+void smv_softmax_tiled_nc_vec_fxp(float16* host_inputs,
+                                  float16* host_results,
+                                  float* inputs,
+                                  float* results,
+                                  float* stats,
+                                  int input_num,
+                                  int input_size,
+                                  int input_pad,
+                                  bool normalize,
+                                  bool init_stats,
+                                  bool read_inputs);
+
 void smv_eltwise_add_nc_vec_fxp(float16* host_inputs0,
                                 float16* host_inputs1,
                                 float16* host_results,
@@ -80,6 +80,11 @@ void SmvPoolingOp::runNHWC(TiledTensor& inputs, TiledTensor& outputs) {
                             outputShape.getPadding(3), getPoolingSize().first,
                             getPoolingSize().second, getPoolingStride().first,
                             getPoolingStride().second, ofmapStart, &sampling);
+                    // The output tile is finished once all the input channels
+                    // pooled into it have been processed.
+                    if (inputChanTiles == outputChanTiles ||
+                        iC == inputChanTiles - 1)
+                        outputs.gatherTileAsync(outputTileIdx);
 
                     ofmapOffset += inputTile->getShape()[3];
                     if (inputChanTiles == outputChanTiles) {
@@ -117,7 +122,7 @@ void SmvPoolingOp::run() {
     {
         auto stats = gem5::ScopedStats(
                 stats::kTensorPrepStart, stats::kTensorPrepEnd);
-        tiledTensors[0].copyDataToAllTiles();
+        tiledTensors[0].prefetchAllTiles();
     }
 
     runNHWC(tiledTensors[0], tiledTensors[1]);
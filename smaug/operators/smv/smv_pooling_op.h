@@ -25,6 +25,12 @@ class SmvPoolingOp : public PoolingOp<SmvBackend> {
     using PoolingOp<SmvBackend>::PoolingOp;
     void tile() override;
     void run() override;
+    TiledTensor* getTiledInput(int index) override {
+        return index == Inputs ? &tiledTensors[0] : nullptr;
+    }
+    TiledTensor* getTiledOutput(int index) override {
+        return index == Outputs ? &tiledTensors[1] : nullptr;
+    }
     friend class smv::pool::TilingOptimizer;
 
    protected:
@@ -125,3 +125,20 @@ TEST_CASE_METHOD(SmvPoolingOpTest, "SMV Tiled Pooling", "[smvpool]") {
     }
 }
 
+
+TEST_CASE_METHOD(SmvPoolingOpTest,
+                 "SMV Tiled Pooling with tile pipelining",
+                 "[smvpool]") {
+    ScopedTilePipelining pipelining;
+    auto poolOp = new SmvMaxPoolingOp("pool", workspace());
+    poolOp->setPoolingSize(2, 2);
+    poolOp->setPoolingStride(2, 2);
+
+    SECTION("DimNC tiling on inputs, None for outputs") {
+        doTest(poolOp, { 1, 32, 32, 32 });
+    }
+    SECTION("DimNC tiling on both inputs and outputs") {
+        doTest(poolOp, { 1, 32, 32, 128 });
+    }
+    SECTION("DimNHW tiling") { doTest(poolOp, { 1, 512, 512, 32 }); }
+}
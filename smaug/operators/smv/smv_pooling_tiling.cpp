@@ -4,6 +4,7 @@
 #include "smaug/operators/common.h"
 #include "smaug/operators/smv/smv_pooling_op.h"
 #include "smaug/operators/smv/smv_pooling_tiling.h"
+#include "smaug/operators/smv/smv_tiling_cache.h"
 #include "smaug/utility/debug_stream.h"
 
 namespace smaug {
@@ -177,10 +178,13 @@ TilingConfig TilingOptimizer::computeBasicTileShapes(SmvPoolingOp* op) {
 std::array<TiledTensor, 2> TilingOptimizer::doTiling(SmvPoolingOp* op) {
     auto input = op->getInput(SmvPoolingOp::Inputs);
     auto output = op->getOutput(SmvPoolingOp::Outputs);
-    TilingConfig tileConfig = TilingOptimizer::computeBasicTileShapes(op);
     int poolRowSize, poolColSize, poolRowStride, poolColStride;
     std::tie(poolRowSize, poolColSize) = op->getPoolingSize();
     std::tie(poolRowStride, poolColStride) = op->getPoolingStride();
+    TilingConfig tileConfig = tilingPlanCache.getOrCompute(
+            op,
+            { poolRowSize, poolColSize, poolRowStride, poolColStride },
+            [op]() { return TilingOptimizer::computeBasicTileShapes(op); });
     TiledTensor tiledInputs =
             generateTiledTensorWithStrideAndPadding(input,
                                                     tileConfig.inputs,
@@ -8,18 +8,20 @@ void SmvSoftmaxOp::tile() {
     auto inputs = getInput(0);
     auto outputs = getOutput(0);
     const TensorShape& shape = inputs->getShape();
-    if (shape.getStorageDim(1) >
-        SmvBackend::SpadSize() / inputs->getDataTypeSize()) {
-        assert(false && "For softmax, a single tile must fit in the local "
-                        "scratchpad size!");
+    int maxTileSize = SmvBackend::SpadSize() / inputs->getDataTypeSize();
+    TensorShape tileShape;
+    if (shape.getStorageDim(1) <= maxTileSize) {
+        // Tile on the N dimension if a whole input fits.
+        int maxInputs =
+                std::min(maxTileSize / shape.getStorageDim(1), shape[0]);
+        tileShape = TensorShape(
+                { maxInputs, shape[1] }, DataLayout::NC, SmvBackend::Alignment);
+    } else {
+        // Otherwise, tile the inputs along the activations as well. These are
+        // run with the online softmax kernel.
+        tileShape = TensorShape(
+                { 1, maxTileSize }, DataLayout::NC, SmvBackend::Alignment);
     }
-    // We can only tile on the N dimension.
-    int maxInputs =
-            std::min(SmvBackend::SpadSize() / inputs->getDataTypeSize() /
-                             shape.getStorageDim(1),
-                     shape[0]);
-    TensorShape tileShape(
-            { maxInputs, shape[1] }, DataLayout::NC, SmvBackend::Alignment);
     tiledTensors[0] = generateTiledTensor(inputs, tileShape, this);
     tiledTensors[1] = generateTiledTensor(outputs, tileShape, this);
 }
@@ -32,6 +34,19 @@ void SmvSoftmaxOp::run() {
             smv::kEltwiseOpHw, "host_inputs", getInputsMemType());
     setArrayMemTypeIfSimulating(
             smv::kEltwiseOpHw, "host_results", getOutputsMemType());
+    if (inputs.getShape()[1] > 1) {
+        runActTiles(inputs, outputs);
+    } else {
+        runNTiles(inputs, outputs);
+    }
+    {
+        auto stats = gem5::ScopedStats(
+                stats::kTensorFinalStart, stats::kTensorFinalEnd);
+        outputs.untile();
+    }
+}
+
+void SmvSoftmaxOp::runNTiles(TiledTensor& inputs, TiledTensor& outputs) {
     for (int i = 0; i < inputs.size(); i++) {
         dout(1) << "Input: " << i << ", output: " << i << "\n";
         Tensor* inputTile = inputs.getTileWithData(i);
@@ -49,10 +64,45 @@ void SmvSoftmaxOp::run() {
                      smv::spad0, smv::spad1, inputShape[0], inputShape[1],
                      inputShape.getPadding(1));
     }
-    {
-        auto stats = gem5::ScopedStats(
-                stats::kTensorFinalStart, stats::kTensorFinalEnd);
-        outputs.untile();
+}
+
+// This runs the inputs tiled along the activations in two passes per batch
+// tile. The reduction pass goes through the activation-wise tiles to find the
+// max and the normalization factor of every input, and the normalization pass
+// goes through them again to produce the outputs. The normalization pass runs
+// backwards, so that the tile the reduction pass ended with is still in the
+// scratchpad and is not read again.
+void SmvSoftmaxOp::runActTiles(TiledTensor& inputs, TiledTensor& outputs) {
+    int inputNumTiles = inputs.getShape()[0];
+    int inputActTiles = inputs.getShape()[1];
+    auto inputIdx = inputs.startIndex();
+    for (int N = 0; N < inputNumTiles; N++) {
+        for (int pass = 0; pass < 2; pass++) {
+            bool normalize = pass == 1;
+            for (int i = 0; i < inputActTiles; i++) {
+                int A = normalize ? inputActTiles - 1 - i : i;
+                int tileIdx = inputIdx(N, A);
+                dout(1) << (normalize ? "Normalize" : "Reduce")
+                        << " input: " << tileIdx << "\n";
+                Tensor* inputTile = inputs.getTileWithData(tileIdx);
+                Tensor* outputTile = outputs[tileIdx];
+                const TensorShape& inputShape = inputTile->getShape();
+                const TensorShape& outputShape = outputTile->getShape();
+                mapArrayToAccel(smv::kEltwiseOpHw, "host_inputs",
+                                inputTile->data<float16>(),
+                                inputShape.storageSize() * sizeof(float16));
+                mapArrayToAccel(smv::kEltwiseOpHw, "host_results",
+                                outputTile->data<float16>(),
+                                outputShape.storageSize() * sizeof(float16));
+                bool readInputs = !normalize || i > 0;
+                invokeKernel(smv::kEltwiseOpHw, smv_softmax_tiled_nc_vec_fxp,
+                             inputTile->data<float16>(),
+                             outputTile->data<float16>(), smv::spad0,
+                             smv::spad1, smv::spad2, inputShape[0],
+                             inputShape[1], inputShape.getPadding(1),
+                             normalize, A == 0, readInputs);
+            }
+        }
     }
 }
 
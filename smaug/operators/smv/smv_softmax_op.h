@@ -15,6 +15,15 @@ class SmvSoftmaxOp : public SoftmaxOp<SmvBackend> {
     void run() override;
 
    protected:
+    /** Runs the inputs tiled on the N dimension only. */
+    void runNTiles(TiledTensor& inputs, TiledTensor& outputs);
+
+    /**
+     * Runs the inputs tiled along the activations with the online softmax
+     * kernel, when a single input does not fit in the scratchpad.
+     */
+    void runActTiles(TiledTensor& inputs, TiledTensor& outputs);
+
     std::array<TiledTensor, 2> tiledTensors;
 };
 
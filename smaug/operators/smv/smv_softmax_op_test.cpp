@@ -0,0 +1,63 @@
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/operators/smv/smv_softmax_op.h"
+#include "smaug/operators/smv/smv_test_common.h"
+
+using namespace smaug;
+
+namespace smaug {
+
+class SmvSoftmaxOpTest : public SmaugTest {
+   public:
+    using SmaugTest::SmaugTest;
+
+    // A reference operator is used to get the 'correct' output.
+    Tensor* getReferenceOutput(SmvSoftmaxOp* softmaxOp) {
+        auto inputs = softmaxOp->getInput(0);
+        auto inputs32 = convertFp16ToFp32Tensor(inputs, workspace());
+        auto refSoftmaxOp =
+                new SoftmaxOp<ReferenceBackend>("ref_softmax", workspace());
+        refSoftmaxOp->setInput(inputs32, 0);
+        refSoftmaxOp->createAllTensors();
+        refSoftmaxOp->getOutput(0)->allocateStorage<float>();
+        refSoftmaxOp->run();
+        return convertFp32ToFp16Tensor(refSoftmaxOp->getOutput(0), workspace());
+    }
+
+    void doTest(const std::vector<int>& dims) {
+        auto softmaxOp = new SmvSoftmaxOp("softmax", workspace());
+        TensorShape inputShape(dims, NC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor("input", inputShape);
+        inputs->allocateStorage<float16>();
+        workspace()->addTensor(inputs);
+        softmaxOp->setInput(inputs, 0);
+        softmaxOp->createAllTensors();
+        softmaxOp->getOutput(0)->allocateStorage<float16>();
+        fillTensorWithRandomData(inputs);
+        // Add a few large activations at the beginning, middle and end of each
+        // input, so that the outputs are not all too small to be checked.
+        float16* data = inputs->data<float16>();
+        int rowSize = inputShape.getStorageDim(1);
+        for (int i = 0; i < dims[0]; i++) {
+            data[i * rowSize] = fp16(8);
+            data[i * rowSize + dims[1] / 2] = fp16(9);
+            data[i * rowSize + dims[1] - 1] = fp16(10);
+        }
+        softmaxOp->tile();
+        softmaxOp->run();
+        auto outputs = softmaxOp->getOutput(0);
+        auto refOutputs = getReferenceOutput(softmaxOp);
+        verifyOutputs<float16>(outputs, refOutputs);
+    }
+};
+
+}  // namespace smaug
+
+TEST_CASE_METHOD(SmvSoftmaxOpTest, "SMV Tiled Softmax", "[smvsoftmax]") {
+    SECTION("No tiling required") { doTest({ 4, 1000 }); }
+    SECTION("DimN tiling") { doTest({ 32, 1000 }); }
+    SECTION("Activation-wise tiling") { doTest({ 1, 40000 }); }
+    SECTION("Activation-wise tiling with padding") { doTest({ 2, 20003 }); }
+}
@@ -1,6 +1,7 @@
 #include <random>
 
 #include "catch.hpp"
+#include "smaug/core/globals.h"
 #include "smaug/core/smaug_test.h"
 #include "smaug/operators/smv/smv_test_common.h"
 
@@ -47,4 +48,19 @@ void verifyTensorWithFixedData(Tensor* tensor, int valueOffset) {
     }
 }
 
+ScopedTilePipelining::ScopedTilePipelining(int numThreads)
+        : prevThreadPool(threadPool), prevFastForwardMode(fastForwardMode) {
+    threadPool = new ThreadPool(numThreads, ThreadPool::Block);
+    threadPool->initThreadPool();
+    fastForwardMode = false;
+    pipelineTiles = true;
+}
+
+ScopedTilePipelining::~ScopedTilePipelining() {
+    delete threadPool;
+    threadPool = prevThreadPool;
+    fastForwardMode = prevFastForwardMode;
+    pipelineTiles = false;
+}
+
 }  // namespace smaug
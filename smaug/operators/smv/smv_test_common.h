@@ -1,4 +1,5 @@
 #include "smaug/core/tensor.h"
+#include "smaug/utility/thread_pool.h"
 
 namespace smaug {
 
@@ -24,4 +25,18 @@ void fillTensorWithFixedData(Tensor* tensor);
  */
 void verifyTensorWithFixedData(Tensor* tensor, int valueOffset);
 
+/**
+ * Enables tile pipelining on a temporary thread pool for as long as this
+ * object is alive, so that tiles are copied in and out in the background.
+ */
+class ScopedTilePipelining {
+   public:
+    ScopedTilePipelining(int numThreads = 2);
+    ~ScopedTilePipelining();
+
+   private:
+    ThreadPool* prevThreadPool;
+    bool prevFastForwardMode;
+};
+
 }  // namespace smaug
@@ -0,0 +1,108 @@
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/scheduler.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/operators/data_op.h"
+#include "smaug/operators/smv/smv_test_common.h"
+#include "smaug/operators/smv/smv_batch_norm_op.h"
+#include "smaug/operators/smv/smv_convolution_op.h"
+#include "smaug/operators/smv/smv_pooling_op.h"
+
+using namespace smaug;
+
+namespace smaug {
+
+class SmvTileForwardingTest : public SmaugTest {
+   public:
+    using SmaugTest::SmaugTest;
+
+    // Adds an operator to the network that reads the output of src, and
+    // creates and fills the rest of its tensors. The input is overwritten when
+    // src runs.
+    void connect(Operator* src, Operator* dest) {
+        network()->addOperator(dest);
+        dest->setInput(src->getOutput(0), 0);
+        network()->addEdge(src, dest, { 0, 0 });
+        createAndFillTensorsWithData<float16>(dest, fillTensorWithRandomData);
+    }
+
+    DataOp<SmvBackend>* addInput(const std::vector<int>& dims) {
+        TensorShape shape(dims, NHWC, SmvBackend::Alignment);
+        Tensor* input = new Tensor("input", shape);
+        input->allocateStorage<float16>();
+        fillTensorWithRandomData(input);
+        workspace()->addTensor(input);
+        auto dataOp = new DataOp<SmvBackend>("data", workspace());
+        dataOp->setData(input);
+        network()->addOperator(dataOp);
+        return dataOp;
+    }
+
+    SmvConvolutionOp* addConv(Operator* src,
+                              const std::string& name,
+                              std::vector<int> kernelDims) {
+        auto convOp = new SmvConvolutionOp(name, workspace());
+        convOp->setStride(1, 1);
+        convOp->setPadding(SamePadding);
+        convOp->setWeightDims(kernelDims[1], kernelDims[2], kernelDims[0]);
+        connect(src, convOp);
+        return convOp;
+    }
+
+    // Runs the producer and consumer one after another without forwarding, and
+    // then through the scheduler, and checks that the consumer's tiles were
+    // forwarded and the final outputs match.
+    void doTest(Operator* producer, Operator* consumer) {
+        producer->tile();
+        producer->run();
+        consumer->tile();
+        consumer->run();
+        Tensor* output = consumer->getOutput(0);
+        Tensor* expected = new Tensor("expected", output->getShape());
+        expected->allocateStorage<float16>();
+        workspace()->addTensor(expected);
+        copyRawTensorData(
+                expected, output, 0, 0, output->getShape().storageSize());
+
+        // Tiling the operators again replaces the tiles in the workspace.
+        Scheduler scheduler(network(), workspace());
+        REQUIRE(scheduler.runNetwork() == output);
+        REQUIRE(producer->getTiledOutput(0)->isForwarded());
+        verifyOutputs<float>(convertFp16ToFp32Tensor(output, workspace()),
+                             convertFp16ToFp32Tensor(expected, workspace()));
+    }
+};
+
+}  // namespace smaug
+
+TEST_CASE_METHOD(SmvTileForwardingTest,
+                 "Forward tiles between SMV operators",
+                 "[smvforward]") {
+    // The shapes are chosen so that the output tiling of the producer matches
+    // the input tiling of the consumer.
+    SECTION("Convolution to convolution") {
+        auto dataOp = addInput({ 1, 32, 32, 64 });
+        auto conv0 = addConv(dataOp, "conv0", { 64, 1, 1, 64 });
+        auto conv1 = addConv(conv0, "conv1", { 64, 1, 1, 64 });
+        doTest(conv0, conv1);
+    }
+
+    SECTION("Convolution to batch norm") {
+        auto dataOp = addInput({ 1, 16, 16, 128 });
+        auto convOp = addConv(dataOp, "conv", { 128, 1, 1, 128 });
+        auto bnOp = new SmvBatchNormOp("bn", workspace());
+        connect(convOp, bnOp);
+        doTest(convOp, bnOp);
+    }
+
+    SECTION("Convolution to pooling") {
+        auto dataOp = addInput({ 1, 16, 16, 128 });
+        auto convOp = addConv(dataOp, "conv", { 128, 1, 1, 128 });
+        auto poolOp = new SmvMaxPoolingOp("pool", workspace());
+        poolOp->setPoolingSize(2, 2);
+        poolOp->setPoolingStride(2, 2);
+        connect(convOp, poolOp);
+        doTest(convOp, poolOp);
+    }
+}
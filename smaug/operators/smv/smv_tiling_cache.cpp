@@ -0,0 +1,165 @@
+#include <fstream>
+#include <sstream>
+
+#include "smaug/core/backend.h"
+#include "smaug/core/globals.h"
+#include "smaug/operators/smv/smv_tiling_cache.h"
+#include "smaug/utility/debug_stream.h"
+
+namespace smaug {
+namespace smv {
+
+TilingPlanCache tilingPlanCache;
+
+namespace {
+
+// Bump this whenever the tiling optimizers change the plans they choose, so
+// that stale cache files are ignored.
+const char* kCacheHeader = "smaug-tiling-plans 4";
+
+void writeShape(std::ostream& os, const TensorShape& shape) {
+    os << shape.ndims();
+    for (int dim : shape.dims())
+        os << " " << dim;
+    os << " " << static_cast<int>(shape.getLayout()) << " "
+       << shape.getAlignment();
+}
+
+bool readShape(std::istream& is, TensorShape& shape) {
+    int ndims;
+    if (!(is >> ndims))
+        return false;
+    if (ndims == 0) {
+        int layout, alignment;
+        is >> layout >> alignment;
+        shape = TensorShape();
+        return bool(is);
+    }
+    std::vector<int> dims(ndims);
+    for (int& dim : dims)
+        is >> dim;
+    int layout, alignment;
+    is >> layout >> alignment;
+    shape = TensorShape(dims, static_cast<DataLayout>(layout), alignment);
+    return bool(is);
+}
+
+bool readTilingDims(std::istream& is, TilingDims& dims) {
+    int value;
+    if (!(is >> value) || value < None || value > Invalid)
+        return false;
+    dims = static_cast<TilingDims>(value);
+    return true;
+}
+
+}  // namespace
+
+std::string TilingPlanCache::getKey(Operator* op,
+                                    const std::vector<int>& params) {
+    std::stringstream key;
+    key << "op " << static_cast<int>(op->getOpType()) << " spad "
+        << SmvBackend::SpadSize(0) << " " << SmvBackend::SpadSize(1) << " "
+        << SmvBackend::SpadSize(2) << " pe " << kNumPEs << " "
+        << kNumMaccsPerPE << " cost " << useTilingCostModel;
+    for (const auto& tensors : { op->getInputs(), op->getOutputs() }) {
+        key << " |";
+        for (TensorBase* tensor : tensors) {
+            key << " ";
+            if (!tensor) {
+                key << "-";
+                continue;
+            }
+            key << static_cast<int>(tensor->getDataType()) << ":";
+            writeShape(key, tensor->getShape());
+        }
+    }
+    key << " | params";
+    for (int param : params)
+        key << " " << param;
+    return key.str();
+}
+
+TilingConfig TilingPlanCache::getOrCompute(
+        Operator* op,
+        const std::vector<int>& params,
+        const std::function<TilingConfig()>& compute) {
+    std::string key = getKey(op, params);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = plans.find(key);
+        if (it != plans.end()) {
+            numHits++;
+            dout(2) << "  Reusing cached tiling plan for " << op->getName()
+                    << ".\n";
+            return it->second;
+        }
+        numMisses++;
+    }
+    TilingConfig config = compute();
+    std::lock_guard<std::mutex> lock(mutex);
+    plans[key] = config;
+    return config;
+}
+
+bool TilingPlanCache::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    std::string line;
+    if (!std::getline(file, line) || line != kCacheHeader) {
+        std::cerr << "Ignoring tiling plan cache " << path
+                  << " written by a different version of SMAUG.\n";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    // Each plan takes two lines: the key and then the TilingConfig.
+    std::string key;
+    while (std::getline(file, key) && std::getline(file, line)) {
+        std::stringstream is(line);
+        TilingConfig config;
+        if (!readShape(is, config.inputs) || !readShape(is, config.weights) ||
+            !readShape(is, config.outputs) ||
+            !readTilingDims(is, config.inputTilingDims) ||
+            !readTilingDims(is, config.weightTilingDims) ||
+            !readTilingDims(is, config.outputTilingDims)) {
+            std::cerr << "Malformed tiling plan in " << path << ": " << line
+                      << "\n";
+            return false;
+        }
+        plans[key] = config;
+    }
+    return true;
+}
+
+void TilingPlanCache::save(const std::string& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Unable to write the tiling plan cache to " << path
+                  << ".\n";
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    file << kCacheHeader << "\n";
+    for (const auto& plan : plans) {
+        const TilingConfig& config = plan.second;
+        file << plan.first << "\n";
+        writeShape(file, config.inputs);
+        file << " ";
+        writeShape(file, config.weights);
+        file << " ";
+        writeShape(file, config.outputs);
+        file << " " << static_cast<int>(config.inputTilingDims) << " "
+             << static_cast<int>(config.weightTilingDims) << " "
+             << static_cast<int>(config.outputTilingDims) << "\n";
+    }
+}
+
+void TilingPlanCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    plans.clear();
+    numHits = 0;
+    numMisses = 0;
+}
+
+}  // namespace smv
+}  // namespace smaug
@@ -0,0 +1,74 @@
+#ifndef _OPERATORS_SMV_SMV_TILING_CACHE_H_
+#define _OPERATORS_SMV_SMV_TILING_CACHE_H_
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "smaug/core/operator.h"
+#include "smaug/operators/smv/smv_tiling_common.h"
+
+namespace smaug {
+namespace smv {
+
+/**
+ * TilingPlanCache memoizes the TilingConfigs chosen by the SMV tiling
+ * optimizers.
+ *
+ * Searching for the best tile shapes enumerates every candidate configuration,
+ * which dominates startup time for large models. The result only depends on
+ * the operator type, the shapes of its tensors, its tiling parameters (e.g.
+ * stride and padding), the scratchpad sizes, the number of PEs and MACCs and
+ * whether the tiling cost model is used, so operators that agree on all of
+ * these, like the repeated blocks of a ResNet, share one search. The cache can
+ * be saved to and loaded from a file so that later runs of the same model skip
+ * the search altogether.
+ */
+class TilingPlanCache {
+   public:
+    TilingPlanCache() : numHits(0), numMisses(0) {}
+
+    /**
+     * Returns the cached TilingConfig for this operator, calling compute() to
+     * find it on a miss.
+     *
+     * @param op The operator being tiled. All of its tensors must have been
+     * created.
+     * @param params Any other operator parameters the tiling depends on, such
+     * as the stride and padding.
+     * @param compute Computes the TilingConfig from scratch.
+     */
+    TilingConfig getOrCompute(Operator* op,
+                              const std::vector<int>& params,
+                              const std::function<TilingConfig()>& compute);
+
+    /** Returns the key the TilingConfig of this operator is cached under. */
+    static std::string getKey(Operator* op, const std::vector<int>& params);
+
+    /** Adds the plans stored in the file. Returns false if it can't be read. */
+    bool load(const std::string& path);
+
+    /** Writes all cached plans to the file. */
+    void save(const std::string& path) const;
+
+    void clear();
+    int size() const { return plans.size(); }
+    int getNumHits() const { return numHits; }
+    int getNumMisses() const { return numMisses; }
+
+   protected:
+    std::map<std::string, TilingConfig> plans;
+    int numHits;
+    int numMisses;
+    mutable std::mutex mutex;
+};
+
+/** The cache shared by all SMV operators. */
+extern TilingPlanCache tilingPlanCache;
+
+}  // namespace smv
+}  // namespace smaug
+
+#endif
@@ -0,0 +1,89 @@
+#include <cstdio>
+
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/operators/smv/smv_convolution_op.h"
+#include "smaug/operators/smv/smv_convolution_tiling.h"
+#include "smaug/operators/smv/smv_test_common.h"
+#include "smaug/operators/smv/smv_tiling_cache.h"
+
+using namespace smaug;
+using namespace smaug::smv;
+
+class TilingCacheTest : public SmaugTest {
+   public:
+    TilingCacheTest() { tilingPlanCache.clear(); }
+    ~TilingCacheTest() { tilingPlanCache.clear(); }
+
+    SmvConvolutionOp* addConv(const std::string& name, int stride) {
+        TensorShape inputShape(
+                { 1, 32, 64, 64 }, DataLayout::NHWC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor(name + "_inputs", inputShape);
+        workspace()->addTensor(inputs);
+        auto convOp = new SmvConvolutionOp(name, workspace());
+        convOp->setStride(stride, stride);
+        convOp->setPadding(SamePadding);
+        convOp->setInput(inputs, 0);
+        convOp->setWeightDims(3, 3, 128);
+        convOp->createAllTensors();
+        allocateAllTensors<float16>(convOp);
+        return convOp;
+    }
+
+    void requireSameTiles(TiledTensor* a, TiledTensor* b) {
+        REQUIRE(a->size() == b->size());
+        for (int i = 0; i < a->size(); i++)
+            REQUIRE((*a)[i]->getShape() == (*b)[i]->getShape());
+    }
+};
+
+TEST_CASE_METHOD(TilingCacheTest, "Memoize tiling plans", "[smvtiling]") {
+    auto conv0 = addConv("conv0", 1);
+    conv0->tile();
+    REQUIRE(tilingPlanCache.getNumMisses() == 1);
+    REQUIRE(tilingPlanCache.getNumHits() == 0);
+
+    SECTION("Identical operators share a plan") {
+        auto conv1 = addConv("conv1", 1);
+        conv1->tile();
+        REQUIRE(tilingPlanCache.getNumMisses() == 1);
+        REQUIRE(tilingPlanCache.getNumHits() == 1);
+        requireSameTiles(conv0->getTiledInput(0), conv1->getTiledInput(0));
+        requireSameTiles(conv0->getTiledOutput(0), conv1->getTiledOutput(0));
+    }
+
+    SECTION("A different stride needs its own plan") {
+        auto conv1 = addConv("conv1", 2);
+        conv1->tile();
+        REQUIRE(tilingPlanCache.getNumMisses() == 2);
+        REQUIRE(tilingPlanCache.getNumHits() == 0);
+        REQUIRE(tilingPlanCache.size() == 2);
+    }
+
+    SECTION("Plans are saved to and loaded from a file") {
+        std::string path = "tiling_plan_cache_test.txt";
+        TilingConfig expected = conv::TilingOptimizer::computeBasicTileShapes(
+                conv0);
+        tilingPlanCache.save(path);
+        tilingPlanCache.clear();
+        REQUIRE(tilingPlanCache.load(path));
+        std::remove(path.c_str());
+        REQUIRE(tilingPlanCache.size() == 1);
+
+        auto conv1 = addConv("conv1", 1);
+        bool computed = false;
+        TilingConfig config = tilingPlanCache.getOrCompute(
+                conv1, { 1, 1, SamePadding }, [&]() {
+                    computed = true;
+                    return TilingConfig();
+                });
+        REQUIRE(!computed);
+        REQUIRE(config.inputs == expected.inputs);
+        REQUIRE(config.weights == expected.weights);
+        REQUIRE(config.outputs == expected.outputs);
+        REQUIRE(config.inputs.getAlignment() == expected.inputs.getAlignment());
+        REQUIRE(config.outputTilingDims == expected.outputTilingDims);
+    }
+}
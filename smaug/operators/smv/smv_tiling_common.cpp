@@ -1,4 +1,5 @@
 #include "smaug/operators/smv/smv_tiling_common.h"
+#include "smaug/core/backend.h"
 #include "smaug/core/tensor_utils.h"
 
 namespace smaug {
@@ -45,6 +46,22 @@ std::ostream& operator<<(std::ostream& os, const TilingConfig& config) {
     return os;
 }
 
+TileSizeLimits getTileSizeLimits(int dataTypeSize) {
+    return { SmvBackend::SpadSize(0) / dataTypeSize,
+             SmvBackend::SpadSize(1) / dataTypeSize,
+             SmvBackend::SpadSize(2) / dataTypeSize };
+}
+
+std::ostream& operator<<(std::ostream& os, const TilingCost& cost) {
+    os << "tiles: " << cost.numInputTiles << "/" << cost.numWeightTiles << "/"
+       << cost.numOutputTiles << ", inputs: " << cost.inputTraffic
+       << ", weights: " << cost.weightTraffic
+       << ", outputs: " << cost.outputTraffic
+       << ", invocations: " << cost.numInvocations
+       << ", total: " << cost.getTotalCost();
+    return os;
+}
+
 // N means batch for inputs/outputs, whereas this can mean ofmap for convolution
 // weights, or neuron for inner product weights.
 bool needsNwiseTiling(TilingDims dim) {
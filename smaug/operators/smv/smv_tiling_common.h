@@ -1,6 +1,8 @@
 #ifndef _OPERATORS_SMV_TILING_COMMON_H_
 #define _OPERATORS_SMV_TILING_COMMON_H_
 
+#include <cstdint>
+
 #include "smaug/core/tensor.h"
 
 namespace smaug {
@@ -31,7 +33,9 @@ struct TilingConfig {
     TilingConfig(TensorShape _inputs = TensorShape(),
                  TensorShape _weights = TensorShape(),
                  TensorShape _outputs = TensorShape())
-            : inputs(_inputs), weights(_weights), outputs(_outputs) {}
+            : inputs(_inputs), weights(_weights), outputs(_outputs),
+              inputTilingDims(None), weightTilingDims(None),
+              outputTilingDims(None) {}
 
     int getTotalSize() const {
         return inputs.storageSize() + weights.storageSize() +
@@ -46,8 +50,62 @@ struct TilingConfig {
     TilingDims outputTilingDims;
 };
 
+/**
+ * The maximum number of elements of the input, weight and output tiles of a
+ * TilingConfig. These reside in separate scratchpads (spad0, spad1 and spad2,
+ * respectively), which can differ in size.
+ */
+struct TileSizeLimits {
+    int inputs;
+    int weights;
+    int outputs;
+};
+
+/** Returns the TileSizeLimits of the SMV scratchpads for this element size. */
+TileSizeLimits getTileSizeLimits(int dataTypeSize);
+
+/**
+ * The fixed cost of a kernel invocation (setting up the accelerator, filling
+ * and draining its pipeline), expressed in elements of data movement so that
+ * it can be added to the traffic of a tiling plan.
+ */
+constexpr int kInvocationCost = 1024;
+
+/**
+ * A TilingCost estimates what running an operator with a TilingConfig costs:
+ * the number of elements moved between the host and the scratchpads, and the
+ * number of kernel invocations.
+ */
+struct TilingCost {
+    TilingCost()
+            : inputTraffic(0), weightTraffic(0), outputTraffic(0),
+              numInvocations(0), numInputTiles(0), numWeightTiles(0),
+              numOutputTiles(0) {}
+
+    int64_t getTotalTraffic() const {
+        return inputTraffic + weightTraffic + outputTraffic;
+    }
+
+    /** Returns the traffic plus kInvocationCost for every invocation. */
+    int64_t getTotalCost() const {
+        return getTotalTraffic() + (int64_t)numInvocations * kInvocationCost;
+    }
+
+    /** Elements of the inputs read, including every reload of a tile. */
+    int64_t inputTraffic;
+    /** Elements of the weights read, including every reload of a tile. */
+    int64_t weightTraffic;
+    /** Elements of the outputs written, including partial sums. */
+    int64_t outputTraffic;
+    int numInvocations;
+    int numInputTiles;
+    int numWeightTiles;
+    int numOutputTiles;
+};
+
 std::ostream& operator<<(std::ostream& os, const TilingDims& dims);
 std::ostream& operator<<(std::ostream& os, const TilingConfig& config);
+std::ostream& operator<<(std::ostream& os, const TilingCost& cost);
 
 bool needsNwiseTiling(TilingDims dim);
 
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "smaug/core/backend.h"
+#include "smaug/operators/smv/smv_convolution_op.h"
+#include "smaug/operators/smv/smv_convolution_tiling.h"
+#include "smaug/operators/smv/smv_inner_product_op.h"
+#include "smaug/operators/smv/smv_inner_product_tiling.h"
+#include "smaug/operators/smv/smv_tiling_sweep.h"
+
+namespace smaug {
+namespace smv {
+
+HardwareConfig HardwareConfig::current() {
+    HardwareConfig config;
+    for (int i = 0; i < 3; i++)
+        config.spadSizes[i] = kSpadSizes[i];
+    config.numPEs = kNumPEs;
+    config.numMaccsPerPE = kNumMaccsPerPE;
+    return config;
+}
+
+void HardwareConfig::apply() const {
+    for (int i = 0; i < 3; i++)
+        kSpadSizes[i] = spadSizes[i];
+    kSpadSize = *std::min_element(spadSizes.begin(), spadSizes.end());
+    kNumPEs = numPEs;
+    kNumMaccsPerPE = numMaccsPerPE;
+}
+
+std::ostream& operator<<(std::ostream& os, const HardwareConfig& config) {
+    os << "spads: " << config.spadSizes[0] << "/" << config.spadSizes[1]
+       << "/" << config.spadSizes[2] << ", PEs: " << config.numPEs
+       << ", MACCs per PE: " << config.numMaccsPerPE;
+    return os;
+}
+
+bool readHardwareConfigs(const std::string& path,
+                         std::vector<HardwareConfig>& configs) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::stringstream fields(line);
+        HardwareConfig config;
+        if (!(fields >> config.spadSizes[0])) {
+            // A blank or comment line.
+            continue;
+        }
+        fields >> config.spadSizes[1] >> config.spadSizes[2] >>
+                config.numPEs >> config.numMaccsPerPE;
+        std::string extra;
+        if (!fields || fields >> extra)
+            return false;
+        configs.push_back(config);
+    }
+    return true;
+}
+
+TilingCost estimateNetworkTiling(Network* network, std::ostream& os) {
+    TilingCost total;
+    for (auto& entry : network->getOperators()) {
+        Operator* op = entry.second;
+        TilingCost cost;
+        if (auto convOp = dynamic_cast<SmvConvolutionOp*>(op)) {
+            TilingConfig config =
+                    conv::TilingOptimizer::computeBasicTileShapes(convOp);
+            cost = conv::TilingOptimizer::estimateCost(convOp, config);
+        } else if (auto fcOp = dynamic_cast<SmvInnerProductOp*>(op)) {
+            TilingConfig config =
+                    fc::TilingOptimizer::computeBasicTileShapes(fcOp);
+            cost = fc::TilingOptimizer::estimateCost(fcOp, config);
+        } else {
+            continue;
+        }
+        os << "  " << op->getName() << " (" << OpType_Name(op->getOpType())
+           << "): " << cost << "\n";
+        total.inputTraffic += cost.inputTraffic;
+        total.weightTraffic += cost.weightTraffic;
+        total.outputTraffic += cost.outputTraffic;
+        total.numInvocations += cost.numInvocations;
+        total.numInputTiles += cost.numInputTiles;
+        total.numWeightTiles += cost.numWeightTiles;
+        total.numOutputTiles += cost.numOutputTiles;
+    }
+    os << "  Total: " << total << "\n";
+    return total;
+}
+
+namespace {
+
+struct SweepWorker {
+    int index;
+    pid_t pid;
+    // The read end of the pipe the worker writes its report to.
+    int fd;
+};
+
+SweepWorker startWorker(Network* network,
+                        const HardwareConfig& config,
+                        int index) {
+    int fds[2];
+    int ret = pipe(fds);
+    assert(ret == 0 && "Failed to create a pipe for a sweep worker!");
+    pid_t pid = fork();
+    assert(pid >= 0 && "Failed to fork a sweep worker!");
+    if (pid == 0) {
+        // Report each operator as soon as it is tiled, so that a config that
+        // fails part way through still shows the operators before it.
+        close(fds[0]);
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[1]);
+        std::cout << std::unitbuf;
+        config.apply();
+        estimateNetworkTiling(network, std::cout);
+        _exit(0);
+    }
+    close(fds[1]);
+    return { index, pid, fds[0] };
+}
+
+// Copies the report of the worker to os and waits for it to exit. Returns
+// false if it failed.
+bool finishWorker(const SweepWorker& worker,
+                  const HardwareConfig& config,
+                  std::ostream& os) {
+    os << "Hardware config " << worker.index << ": " << config << "\n";
+    char buffer[4096];
+    ssize_t bytes;
+    while ((bytes = read(worker.fd, buffer, sizeof(buffer))) > 0)
+        os.write(buffer, bytes);
+    close(worker.fd);
+    int status;
+    waitpid(worker.pid, &status, 0);
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        return true;
+    os << "  Failed: no tiling plan fits this configuration.\n";
+    return false;
+}
+
+}  // namespace
+
+int runTilingSweep(Network* network,
+                   const std::vector<HardwareConfig>& configs,
+                   int numWorkers,
+                   std::ostream& os) {
+    numWorkers = std::max(numWorkers, 1);
+    int numFailed = 0;
+    std::deque<SweepWorker> workers;
+    for (int i = 0; i < configs.size(); i++) {
+        if (workers.size() == numWorkers) {
+            if (!finishWorker(workers.front(), configs[workers.front().index],
+                              os))
+                numFailed++;
+            workers.pop_front();
+        }
+        // Anything still buffered would otherwise be printed again by the
+        // worker.
+        os.flush();
+        std::cout.flush();
+        std::cerr.flush();
+        workers.push_back(startWorker(network, configs[i], i));
+    }
+    for (const SweepWorker& worker : workers) {
+        if (!finishWorker(worker, configs[worker.index], os))
+            numFailed++;
+    }
+    return numFailed;
+}
+
+}  // namespace smv
+}  // namespace smaug
@@ -0,0 +1,74 @@
+#ifndef _OPERATORS_SMV_SMV_TILING_SWEEP_H_
+#define _OPERATORS_SMV_SMV_TILING_SWEEP_H_
+
+#include <array>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "smaug/core/network.h"
+#include "smaug/operators/smv/smv_tiling_common.h"
+
+namespace smaug {
+namespace smv {
+
+/**
+ * The geometry of an SMV accelerator that the tiling optimizers plan for:
+ * the sizes of its three scratchpads and the shape of its PE array.
+ */
+struct HardwareConfig {
+    /** Returns the geometry the backend is currently configured with. */
+    static HardwareConfig current();
+
+    /**
+     * Sets the smv globals to this geometry. Must be called before
+     * SmvBackend::initGlobals() if the operators will also be run.
+     */
+    void apply() const;
+
+    /** The scratchpad sizes, in bytes of float16 data. */
+    std::array<int, 3> spadSizes;
+    int numPEs;
+    int numMaccsPerPE;
+};
+
+std::ostream& operator<<(std::ostream& os, const HardwareConfig& config);
+
+/**
+ * Reads hardware configurations from a file, one per line, as
+ *
+ *   spad0 spad1 spad2 numPEs numMaccsPerPE
+ *
+ * Everything after a '#' is a comment. Returns false if the file can't be read
+ * or a line is malformed.
+ */
+bool readHardwareConfigs(const std::string& path,
+                         std::vector<HardwareConfig>& configs);
+
+/**
+ * Tiles every SMV convolution and inner product operator of the network for
+ * the current hardware configuration, and prints the tile counts and
+ * estimated traffic of each. Returns the sum over all the operators.
+ */
+TilingCost estimateNetworkTiling(Network* network, std::ostream& os);
+
+/**
+ * Runs estimateNetworkTiling() for each of the hardware configurations and
+ * prints a report for each to os, in the order of configs.
+ *
+ * The hardware geometry is process-wide state read by the tiling optimizers,
+ * so every configuration is tiled in a child process of its own, with up to
+ * numWorkers of them running at once. A configuration that no tiling plan fits
+ * is reported as failed instead of bringing down the sweep.
+ *
+ * @returns The number of configurations that failed.
+ */
+int runTilingSweep(Network* network,
+                   const std::vector<HardwareConfig>& configs,
+                   int numWorkers,
+                   std::ostream& os);
+
+}  // namespace smv
+}  // namespace smaug
+
+#endif
@@ -0,0 +1,164 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "catch.hpp"
+#include "smaug/core/backend.h"
+#include "smaug/core/smaug_test.h"
+#include "smaug/core/tensor.h"
+#include "smaug/operators/smv/smv_convolution_op.h"
+#include "smaug/operators/smv/smv_convolution_tiling.h"
+#include "smaug/operators/smv/smv_inner_product_op.h"
+#include "smaug/operators/smv/smv_inner_product_tiling.h"
+#include "smaug/operators/smv/smv_test_common.h"
+#include "smaug/operators/smv/smv_tiling_sweep.h"
+
+using namespace smaug;
+using namespace smaug::smv;
+
+class TilingSweepTest : public SmaugTest {
+   public:
+    TilingSweepTest() : defaultConfig(HardwareConfig::current()) {}
+    ~TilingSweepTest() { defaultConfig.apply(); }
+
+    SmvConvolutionOp* addConv(const std::string& name, int channels = 64) {
+        TensorShape inputShape({ 1, 32, 64, channels }, DataLayout::NHWC,
+                               SmvBackend::Alignment);
+        Tensor* inputs = new Tensor(name + "_inputs", inputShape);
+        workspace()->addTensor(inputs);
+        auto convOp = new SmvConvolutionOp(name, workspace());
+        convOp->setStride(1, 1);
+        convOp->setPadding(SamePadding);
+        convOp->setInput(inputs, 0);
+        convOp->setWeightDims(3, 3, 128);
+        convOp->createAllTensors();
+        allocateAllTensors<float16>(convOp);
+        network()->addOperator(convOp);
+        return convOp;
+    }
+
+    SmvInnerProductOp* addFc(const std::string& name) {
+        TensorShape inputShape(
+                { 1, 64 }, DataLayout::NC, SmvBackend::Alignment);
+        Tensor* inputs = new Tensor(name + "_inputs", inputShape);
+        workspace()->addTensor(inputs);
+        auto fcOp = new SmvInnerProductOp(name, workspace());
+        fcOp->setInput(inputs, 0);
+        fcOp->setNumOutputs(20000);
+        fcOp->createAllTensors();
+        allocateAllTensors<float16>(fcOp);
+        network()->addOperator(fcOp);
+        return fcOp;
+    }
+
+   protected:
+    HardwareConfig defaultConfig;
+};
+
+TEST_CASE_METHOD(TilingSweepTest,
+                 "Tiling follows the hardware geometry",
+                 "[smvtiling]") {
+    auto fcOp = addFc("fc");
+    TilingConfig config = fc::TilingOptimizer::computeBasicTileShapes(fcOp);
+    REQUIRE(config.weights.dims() == std::vector<int>{ 256, 64 });
+    REQUIRE(config.outputs.dims() == std::vector<int>{ 1, 256 });
+
+    SECTION("Larger weight scratchpad") {
+        kSpadSizes[1] = 64 * 1024;
+        config = fc::TilingOptimizer::computeBasicTileShapes(fcOp);
+        REQUIRE(config.weights.dims() == std::vector<int>{ 512, 64 });
+        REQUIRE(config.outputs.dims() == std::vector<int>{ 1, 512 });
+    }
+
+    SECTION("Fewer PEs") {
+        kNumPEs = 6;
+        config = fc::TilingOptimizer::computeBasicTileShapes(fcOp);
+        REQUIRE(config.weights.dims() == std::vector<int>{ 252, 64 });
+        REQUIRE(config.outputs.dims() == std::vector<int>{ 1, 252 });
+    }
+
+    SECTION("Narrower PEs") {
+        auto convOp = addConv("conv", 1024);
+        TilingConfig convConfig =
+                conv::TilingOptimizer::computeBasicTileShapes(convOp);
+        REQUIRE(convConfig.weights.dims() ==
+                std::vector<int>{ 48, 3, 3, 32 });
+        // Input channels are tiled in multiples of the PE width.
+        kNumMaccsPerPE = 24;
+        convConfig = conv::TilingOptimizer::computeBasicTileShapes(convOp);
+        REQUIRE(convConfig.weights.dims() ==
+                std::vector<int>{ 64, 3, 3, 24 });
+    }
+}
+
+TEST_CASE_METHOD(TilingSweepTest, "Read hardware configs", "[smvtiling]") {
+    std::string path = "tiling_sweep_test_configs.txt";
+    std::vector<HardwareConfig> configs;
+
+    SECTION("Well-formed file") {
+        std::ofstream(path) << "# spad0 spad1 spad2 PEs MACCs\n"
+                            << "32768 32768 32768 8 32\n"
+                            << "\n"
+                            << "16384 65536 8192 4 16  # Small inputs.\n";
+        REQUIRE(readHardwareConfigs(path, configs));
+        REQUIRE(configs.size() == 2);
+        REQUIRE(configs[1].spadSizes ==
+                std::array<int, 3>{ 16384, 65536, 8192 });
+        REQUIRE(configs[1].numPEs == 4);
+        REQUIRE(configs[1].numMaccsPerPE == 16);
+    }
+
+    SECTION("Malformed line") {
+        std::ofstream(path) << "32768 32768 32768 8\n";
+        REQUIRE(!readHardwareConfigs(path, configs));
+    }
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE_METHOD(TilingSweepTest, "Sweep hardware configs", "[smvtiling]") {
+    addConv("conv");
+    addFc("fc");
+    std::vector<HardwareConfig> configs(3, defaultConfig);
+    configs[1].spadSizes = { 16 * 1024, 64 * 1024, 16 * 1024 };
+    configs[2].numPEs = 4;
+    configs[2].numMaccsPerPE = 16;
+
+    // Each config is reported as if it were tiled in this process.
+    std::stringstream expected;
+    for (int i = 0; i < configs.size(); i++) {
+        configs[i].apply();
+        expected << "Hardware config " << i << ": " << configs[i] << "\n";
+        estimateNetworkTiling(network(), expected);
+    }
+    defaultConfig.apply();
+
+    SECTION("One worker") {
+        std::stringstream report;
+        REQUIRE(runTilingSweep(network(), configs, 1, report) == 0);
+        REQUIRE(report.str() == expected.str());
+    }
+
+    SECTION("More workers than configs") {
+        std::stringstream report;
+        REQUIRE(runTilingSweep(network(), configs, 4, report) == 0);
+        REQUIRE(report.str() == expected.str());
+    }
+
+    SECTION("A config that no plan fits fails on its own") {
+        configs[1].spadSizes = { 64, 64, 64 };
+        std::stringstream report;
+        REQUIRE(runTilingSweep(network(), configs, 2, report) == 1);
+        std::string text = report.str();
+        REQUIRE(text.find("Failed") != std::string::npos);
+        REQUIRE(text.find("Hardware config 2") != std::string::npos);
+    }
+
+    SECTION("The sweep doesn't change the current config") {
+        std::stringstream report;
+        runTilingSweep(network(), configs, 2, report);
+        REQUIRE(kNumPEs == defaultConfig.numPEs);
+        REQUIRE(kNumMaccsPerPE == defaultConfig.numMaccsPerPE);
+        REQUIRE(kSpadSizes[0] == defaultConfig.spadSizes[0]);
+    }
+}
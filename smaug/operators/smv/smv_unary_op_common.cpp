@@ -101,7 +101,7 @@ void run(UnaryOp<SmvBackend>* op, std::array<TiledTensor, 2>& tiledTensors) {
     {
         auto stats = gem5::ScopedStats(
                 stats::kTensorPrepStart, stats::kTensorPrepEnd);
-        tiledTensors[0].copyDataToAllTiles();
+        tiledTensors[0].prefetchAllTiles();
     }
 
     runX(op, tiledTensors[0], tiledTensors[1]);
@@ -71,6 +71,8 @@ class SplitOp : public Operator {
         }
     }
 
+    bool isHostOnly() const override { return true; }
+
     void run() override {
         Tensor* input = getInput(0);
         int ndims = input->ndims();
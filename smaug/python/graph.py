@@ -1,6 +1,8 @@
 from __future__ import print_function
 
+import struct
 from collections import namedtuple
+import numpy as np
 from google.protobuf import text_format
 
 from smaug.core import graph_pb2
@@ -182,21 +184,35 @@ class Graph:
       graph_proto.nodes.append(node.to_proto(tensor_data_array))
     return graph_proto, tensor_data_array
 
-  def write_graph(self, name=None):
+  def write_graph(self, name=None, raw_params=False, binary_topo=False):
     """Serialize the graph to a protobuf file.
 
     Args:
       name: Name of the output protobuf file. If not specified, use the graph's
             name instead.
+      raw_params: If true, write the parameters in the raw format (as
+            "<name>_params.bin") instead of as a protobuf. SMAUG memory maps
+            raw parameters files, so large models load much faster.
+      binary_topo: If true, write the topology in the binary format (as
+            "<name>_topo.bin") instead of as a text protobuf. Text topologies
+            are easier to read and edit, but parsing them dominates the
+            loading time of graphs with thousands of nodes.
     """
     graph_proto, tensor_data_array = self.to_proto()
     if name is None:
       name = self._name
-    topo_name = name + "_topo.pbtxt"
-    params_name = name + "_params.pb"
-    with open(topo_name, "w") as f_topo, open(params_name, "wb") as f_params:
-      f_topo.write(text_format.MessageToString(graph_proto))
-      f_params.write(tensor_data_array.SerializeToString())
+    if binary_topo:
+      with open(name + "_topo.bin", "wb") as f_topo:
+        write_binary_topo(f_topo, graph_proto)
+    else:
+      with open(name + "_topo.pbtxt", "w") as f_topo:
+        f_topo.write(text_format.MessageToString(graph_proto))
+    if raw_params:
+      with open(name + "_params.bin", "wb") as f_params:
+        write_raw_params(f_params, graph_proto, tensor_data_array)
+    else:
+      with open(name + "_params.pb", "wb") as f_params:
+        f_params.write(tensor_data_array.SerializeToString())
 
   def print_summary(self):
     """Print the summary of the graph.
@@ -248,3 +264,81 @@ def get_node_proto(graph_proto, node_name):
     if node_proto.name == node_name:
       return node_proto
   return None
+
+# The binary topology format. See smaug/core/network_builder.h for the layout.
+BINARY_TOPO_MAGIC = b"SMAUGTOP"
+BINARY_TOPO_VERSION = 1
+
+def write_binary_topo(f, graph_proto):
+  """Write the graph topology to a file in the binary format.
+
+  Args:
+    f: A file opened for binary writing.
+    graph_proto: The `GraphProto` to write.
+  """
+  f.write(struct.pack("<8sI", BINARY_TOPO_MAGIC, BINARY_TOPO_VERSION))
+  f.write(graph_proto.SerializeToString())
+
+# The raw parameters format. See smaug/core/param_file.h for the layout.
+RAW_PARAMS_MAGIC = b"SMAUGRAW"
+RAW_PARAMS_VERSION = 1
+RAW_PARAMS_ALIGNMENT = 64
+
+def _get_raw_tensor_data(tensor_data, data_type):
+  """Return the contents of a `TensorData` as raw bytes."""
+  if data_type == types_pb2.Float16:
+    # Two float16 elements are already packed into each int32.
+    return np.array(tensor_data.half_data, dtype=np.int32).tobytes()
+  elif data_type == types_pb2.Float32:
+    return np.array(tensor_data.float_data, dtype=np.float32).tobytes()
+  elif data_type == types_pb2.Float64:
+    return np.array(tensor_data.double_data, dtype=np.float64).tobytes()
+  elif data_type == types_pb2.Int32:
+    return np.array(tensor_data.int_data, dtype=np.int32).tobytes()
+  elif data_type == types_pb2.Int64:
+    return np.array(tensor_data.int64_data, dtype=np.int64).tobytes()
+  elif data_type == types_pb2.Bool:
+    return np.array(tensor_data.bool_data, dtype=np.bool_).tobytes()
+  raise ValueError("Unknown data type %s!" % data_type)
+
+def _align_raw_offset(offset):
+  """Round the offset up to the alignment of the raw tensor data."""
+  remainder = offset % RAW_PARAMS_ALIGNMENT
+  if remainder == 0:
+    return offset
+  return offset + RAW_PARAMS_ALIGNMENT - remainder
+
+def write_raw_params(f, graph_proto, tensor_data_array):
+  """Write the tensor data to a file in the raw parameters format.
+
+  Args:
+    f: A file opened for binary writing.
+    graph_proto: The `GraphProto` that the tensors belong to.
+    tensor_data_array: The `TensorDataArray` to write.
+  """
+  data_types = {}
+  for node in graph_proto.nodes:
+    for tensor in node.input_tensors:
+      data_types[tensor.name] = tensor.data_type
+  entries = []
+  for tensor_data in tensor_data_array.data_array:
+    data_type = data_types[tensor_data.name]
+    entries.append((
+        tensor_data.name.encode(), data_type,
+        _get_raw_tensor_data(tensor_data, data_type)))
+
+  header_size = len(RAW_PARAMS_MAGIC) + 8 + sum(
+      4 + len(name) + 4 + 16 for name, _, _ in entries)
+  header = [struct.pack(
+      "<8sII", RAW_PARAMS_MAGIC, RAW_PARAMS_VERSION, len(entries))]
+  offset = _align_raw_offset(header_size)
+  offsets = []
+  for name, data_type, data in entries:
+    header.append(struct.pack("<I", len(name)) + name)
+    header.append(struct.pack("<iQQ", data_type, offset, len(data)))
+    offsets.append(offset)
+    offset = _align_raw_offset(offset + len(data))
+  f.write(b"".join(header))
+  for (_, _, data), offset in zip(entries, offsets):
+    f.write(b"\0" * (offset - f.tell()))
+    f.write(data)
@@ -2,14 +2,18 @@
 
 """Tests for python/tensor.py."""
 
+import io
+import struct
 import unittest
 import numpy as np
 
 from smaug.python.tensor_utils import get_tensor_data
-from smaug.python.graph import Graph, get_node_proto
+from smaug.python.graph import (
+    Graph, get_node_proto, write_raw_params, write_binary_topo)
 from smaug.python.tensor import Tensor
 from smaug.python.ops.data_op import input_data
 from smaug.core import types_pb2
+from smaug.core import graph_pb2
 
 class TensorTestBase(unittest.TestCase):
   def assertEqualFP16(self, packed_fp16_data, unpacked_fp16_data):
@@ -136,5 +140,65 @@ class FP16Test(TensorTestBase):
     self.assertEqualFP16(tensor_data_proto.half_data,
                          np.append(tensor_data.flatten(), np.float16(0)))
 
+class RawParamsTest(unittest.TestCase):
+  def test_raw_params(self):
+    """Test writing tensor data in the raw parameters format."""
+    float_data = np.random.rand(2, 3).astype(np.float32)
+    half_data = np.random.rand(3, 3).astype(np.float16)
+    with Graph("test_graph", "SMV") as test_graph:
+      float_tensor = Tensor(data_layout=types_pb2.NC, tensor_data=float_data)
+      half_tensor = Tensor(data_layout=types_pb2.NC, tensor_data=half_data)
+      input_data(float_tensor, "float_input")
+      input_data(half_tensor, "half_input")
+    graph_proto, tensor_data_array = test_graph.to_proto()
+    f = io.BytesIO()
+    write_raw_params(f, graph_proto, tensor_data_array)
+    raw = f.getvalue()
+
+    magic, version, num_tensors = struct.unpack_from("<8sII", raw, 0)
+    self.assertEqual(magic, b"SMAUGRAW")
+    self.assertEqual(version, 1)
+    self.assertEqual(num_tensors, 2)
+    pos = 16
+    blobs = {}
+    for i in range(num_tensors):
+      name_len, = struct.unpack_from("<I", raw, pos)
+      name = raw[pos + 4:pos + 4 + name_len].decode()
+      pos += 4 + name_len
+      data_type, offset, size = struct.unpack_from("<iQQ", raw, pos)
+      pos += 20
+      self.assertEqual(offset % 64, 0)
+      blobs[name] = (data_type, raw[offset:offset + size])
+
+    # The raw data includes the alignment padding of the last dimension.
+    data_type, blob = blobs[float_tensor.name]
+    self.assertEqual(data_type, types_pb2.Float32)
+    padded = np.frombuffer(blob, dtype=np.float32).reshape(2, 8)
+    np.testing.assert_array_equal(padded[:, :3], float_data)
+    np.testing.assert_array_equal(padded[:, 3:], 0)
+    data_type, blob = blobs[half_tensor.name]
+    self.assertEqual(data_type, types_pb2.Float16)
+    padded = np.frombuffer(blob, dtype=np.float16).reshape(3, 8)
+    np.testing.assert_array_equal(padded[:, :3], half_data)
+
+  def test_binary_topo(self):
+    """Test writing the graph topology in the binary format."""
+    with Graph("test_graph", "SMV") as test_graph:
+      input_tensor = Tensor(
+          data_layout=types_pb2.NC,
+          tensor_data=np.random.rand(2, 3).astype(np.float16))
+      input_data(input_tensor, "input")
+    graph_proto, _ = test_graph.to_proto()
+    f = io.BytesIO()
+    write_binary_topo(f, graph_proto)
+    raw = f.getvalue()
+
+    magic, version = struct.unpack_from("<8sI", raw, 0)
+    self.assertEqual(magic, b"SMAUGTOP")
+    self.assertEqual(version, 1)
+    parsed = graph_pb2.GraphProto()
+    parsed.ParseFromString(raw[12:])
+    self.assertEqual(parsed, graph_proto)
+
 if __name__ == "__main__":
   unittest.main()
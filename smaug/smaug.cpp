@@ -1,13 +1,20 @@
+#include <algorithm>
 #include <fstream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
 
 #include <boost/program_options.hpp>
 
 #include "core/backend.h"
 #include "core/globals.h"
-#include "core/scheduler.h"
-#include "core/network_builder.h"
+#include "core/session.h"
 #include "operators/common.h"
+#include "operators/smv/smv_accel_pool.h"
+#include "operators/smv/smv_tiling_cache.h"
+#include "operators/smv/smv_tiling_sweep.h"
+#include "operators/smv/kernels/params.h"
 #include "utility/debug_stream.h"
 #include "utility/utils.h"
 #include "utility/thread_pool.h"
@@ -16,6 +23,21 @@ namespace po = boost::program_options;
 
 using namespace smaug;
 
+// Returns an error message if the accelerators can't be built with this
+// geometry, or an empty string otherwise.
+static std::string checkHardwareConfig(const smv::HardwareConfig& config) {
+    for (int size : config.spadSizes) {
+        if (size <= 0)
+            return "The scratchpad sizes must be positive!";
+    }
+    if (config.numPEs <= 0)
+        return "The number of PEs must be positive!";
+    if (config.numMaccsPerPE <= 0 || config.numMaccsPerPE % VECTOR_SIZE != 0)
+        return "The number of MACCs per PE must be a positive multiple of " +
+               std::to_string(VECTOR_SIZE) + "!";
+    return "";
+}
+
 int main(int argc, char* argv[]) {
     std::string modelTopo;
     std::string modelParams;
@@ -28,7 +50,15 @@ int main(int argc, char* argv[]) {
     sampling.num_sample_iterations = 1;
     numAcceleratorsAvailable = 1;
     int numThreads = -1;
+    int numSchedulerThreads = 0;
+    std::string tilingCacheFile;
+    std::string packedWeightsFile;
+    std::string accelDispatch = "round-robin";
+    std::string accelDispatchLogFile;
     useSystolicArrayWhenAvailable = false;
+    std::string spadSizes;
+    smv::HardwareConfig hwConfig = smv::HardwareConfig::current();
+    std::string tilingSweepFile;
     po::options_description options(
             "SMAUG Usage:  ./smaug model_topo.pbtxt model_params.pb [options]");
     // clang-format off
@@ -67,9 +97,90 @@ int main(int argc, char* argv[]) {
         ("num-threads",
          po::value(&numThreads)->implicit_value(1),
          "Number of threads in the thread pool.")
+        ("scheduler-threads",
+         po::value(&numSchedulerThreads)->implicit_value(1),
+         "Number of threads used to run independent operators concurrently. "
+         "By default, operators are run one at a time in topological order.")
         ("use-systolic-array",
          po::value(&useSystolicArrayWhenAvailable)->implicit_value(true),
-         "If the backend contains a systolic array, use it whenever possible.");
+         "If the backend contains a systolic array, use it whenever possible.")
+        ("pipeline-tiles",
+         po::value(&pipelineTiles)->implicit_value(true),
+         "Overlap copying data into and out of tiles with kernel execution. "
+         "Requires a thread pool (see --num-threads).")
+        ("tile-views",
+         po::value(&useTileViews)->implicit_value(true),
+         "Make tiles that occupy a contiguous range of the tiled tensor "
+         "(e.g. batch tiles) views into its storage instead of copies. "
+         "Enabled by default.")
+        ("arena-allocators",
+         po::value(&useArenaAllocators)->implicit_value(true),
+         "Allocate long-lived tensors from an arena and tiles from a pool "
+         "of size classes, instead of allocating every tensor separately. "
+         "Enabled by default.")
+        ("lazy-params",
+         po::value(&lazyLoadParams)->implicit_value(true),
+         "With a raw parameters file, read the weights of each operator in "
+         "right before it runs, and drop them from memory after their last "
+         "consumer has run, so that models larger than memory can run.")
+        ("tiling-cost-model",
+         po::value(&useTilingCostModel)->implicit_value(true),
+         "Pick the SMV tiling plans that move the least data between the "
+         "host and the accelerators, counting tile reloads and kernel "
+         "invocations, instead of the ones that fill the scratchpads most.")
+        ("plan-memory",
+         po::value(&planTensorMemory)->implicit_value(true),
+         "Reuse the host memory of intermediate tensors once all of their "
+         "consumers have run. Enabled by default.")
+        ("allocate-on-demand",
+         po::value(&allocateTensorsOnDemand)->implicit_value(true),
+         "Allocate the outputs of an operator only when it is scheduled, and "
+         "free them after their last consumer has run. Tensors on untaken "
+         "control flow paths are never allocated. Overrides --plan-memory.")
+        ("spad-sizes",
+         po::value(&spadSizes),
+         "The sizes of the SMV scratchpads in bytes: either one size for all "
+         "three, or three comma-separated sizes for spad0, spad1 and spad2 "
+         "(which hold the inputs, weights and outputs of convolutions and "
+         "inner products). Defaults to 32768.")
+        ("num-pes",
+         po::value(&hwConfig.numPEs),
+         "The number of PEs of the SMV convolution and inner product engines "
+         "that the tiling plans for. Defaults to 8.")
+        ("num-maccs-per-pe",
+         po::value(&hwConfig.numMaccsPerPE),
+         "The number of MACCs in each SMV PE that the tiling plans for. Must "
+         "be a multiple of 8. Defaults to 32.")
+        ("tiling-sweep",
+         po::value(&tilingSweepFile),
+         "Instead of running the network, tile its SMV convolutions and inner "
+         "products for every hardware configuration in this file, and report "
+         "the tile counts and traffic of each. Each line of the file holds "
+         "the three scratchpad sizes, the number of PEs and the number of "
+         "MACCs per PE. The configurations are tiled in parallel, as many at "
+         "a time as --num-threads.")
+        ("tiling-cache",
+         po::value(&tilingCacheFile),
+         "Load the tiling plans of SMV operators from this file, and save any "
+         "new plans to it after the run, so that later runs skip the search "
+         "for the best tile shapes.")
+        ("packed-weights",
+         po::value(&packedWeightsFile),
+         "Map the weights of SMV operators, already split into tiles, from "
+         "this file. If it doesn't exist or was packed for a different "
+         "tiling, the weight tiles are packed into it instead, so that later "
+         "runs skip preparing the weights.")
+        ("accel-dispatch",
+         po::value(&accelDispatch)->implicit_value("round-robin"),
+         "How tiles are distributed across multiple accelerators: "
+         "round-robin (the default), or first-finished, which gives the next "
+         "tile to whichever accelerator becomes idle first.")
+        ("accel-dispatch-log",
+         po::value(&accelDispatchLogFile),
+         "With --accel-dispatch=first-finished, save the accelerators picked "
+         "in gem5 simulation to this file. Outside of simulation (e.g. when "
+         "generating traces), the decisions are replayed from this file "
+         "instead, so that the traces match the simulation.");
     // clang-format on
 
     po::options_description hidden;
@@ -142,14 +253,63 @@ int main(int argc, char* argv[]) {
                      "by 1.\n";
     }
 
+    if (accelDispatch == "round-robin") {
+        accelDispatchPolicy = RoundRobin;
+    } else if (accelDispatch == "first-finished") {
+        accelDispatchPolicy = FirstFinished;
+        if (!runningInSimulation && !accelDispatchLogFile.empty()) {
+            if (!accelDispatchLog.load(accelDispatchLogFile)) {
+                std::cout << "Unable to read the accelerator dispatch log "
+                          << accelDispatchLogFile << "!\n";
+                exit(1);
+            }
+            std::cout << "Replaying " << accelDispatchLog.size()
+                      << " accelerator dispatch decisions.\n";
+        }
+    } else {
+        std::cout << "Doesn't support the specified accelerator dispatch "
+                     "policy: "
+                  << accelDispatch << "\n";
+        exit(1);
+    }
+
+    if (!spadSizes.empty()) {
+        std::stringstream sizes(spadSizes);
+        std::vector<int> values;
+        std::string value;
+        while (std::getline(sizes, value, ','))
+            values.push_back(std::atoi(value.c_str()));
+        if (values.size() == 1) {
+            hwConfig.spadSizes.fill(values[0]);
+        } else if (values.size() == 3) {
+            std::copy(values.begin(), values.end(), hwConfig.spadSizes.begin());
+        } else {
+            std::cout << "--spad-sizes takes one or three sizes!\n";
+            exit(1);
+        }
+    }
+    std::string hwConfigError = checkHardwareConfig(hwConfig);
+    if (!hwConfigError.empty()) {
+        std::cout << hwConfigError << "\n";
+        exit(1);
+    }
+    hwConfig.apply();
+    std::cout << "SMV hardware: " << hwConfig << "\n";
+
     if (numThreads != -1) {
         std::cout << "Using a thread pool, size: " << numThreads << ".\n";
-        threadPool = new ThreadPool(numThreads);
+        threadPool = new ThreadPool(
+                numThreads, runningInSimulation ? ThreadPool::Quiesce
+                                                : ThreadPool::Block);
     }
 
-    Workspace* workspace = new Workspace();
-    Network* network =
-            buildNetwork(modelTopo, modelParams, sampling, workspace);
+    auto session = std::make_unique<Session>(
+            modelTopo, modelParams, sampling, numSchedulerThreads);
+    Network* network = session->getNetwork();
+    // The network is run only once.
+    session->setSingleShot(true);
+    if (!packedWeightsFile.empty())
+        session->setPackedWeightsFile(packedWeightsFile);
     ReferenceBackend::initGlobals();
     SmvBackend::initGlobals();
 
@@ -159,8 +319,48 @@ int main(int argc, char* argv[]) {
     if (!network->validate())
         return -1;
 
-    Scheduler scheduler(network, workspace);
-    Tensor* output = scheduler.runNetwork();
+    if (!tilingSweepFile.empty()) {
+        std::vector<smv::HardwareConfig> configs;
+        if (!smv::readHardwareConfigs(tilingSweepFile, configs)) {
+            std::cout << "Unable to read the hardware configurations from "
+                      << tilingSweepFile << "!\n";
+            exit(1);
+        }
+        for (const auto& config : configs) {
+            hwConfigError = checkHardwareConfig(config);
+            if (!hwConfigError.empty()) {
+                std::cout << config << ": " << hwConfigError << "\n";
+                exit(1);
+            }
+        }
+        int numWorkers = numThreads > 0 ? numThreads
+                                        : std::thread::hardware_concurrency();
+        std::cout << "Sweeping " << configs.size()
+                  << " hardware configurations, " << numWorkers
+                  << " at a time.\n";
+        int numFailed =
+                smv::runTilingSweep(network, configs, numWorkers, std::cout);
+        if (threadPool)
+            delete threadPool;
+        session.reset();
+        ReferenceBackend::freeGlobals();
+        SmvBackend::freeGlobals();
+        return numFailed > 0 ? 1 : 0;
+    }
+
+    if (!tilingCacheFile.empty() &&
+        smv::tilingPlanCache.load(tilingCacheFile)) {
+        std::cout << "Loaded " << smv::tilingPlanCache.size()
+                  << " tiling plans from " << tilingCacheFile << ".\n";
+    }
+
+    Tensor* output = session->run();
+
+    if (!tilingCacheFile.empty() && smv::tilingPlanCache.getNumMisses() > 0)
+        smv::tilingPlanCache.save(tilingCacheFile);
+    if (runningInSimulation && accelDispatchPolicy == FirstFinished &&
+        !accelDispatchLogFile.empty())
+        accelDispatchLog.save(accelDispatchLogFile);
 
     if (!lastOutputFile.empty()) {
         if (lastOutputFile == "stdout") {
@@ -186,8 +386,7 @@ int main(int argc, char* argv[]) {
     if (threadPool)
         delete threadPool;
 
-    delete network;
-    delete workspace;
+    session.reset();
     ReferenceBackend::freeGlobals();
     SmvBackend::freeGlobals();
 
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "smaug/utility/thread_pool.h"
 #include "smaug/utility/utils.h"
 #include "smaug/core/globals.h"
@@ -5,59 +7,74 @@
 
 namespace smaug {
 
-ThreadPool::ThreadPool(int nthreads) : workers(nthreads) {}
+/** The pool that the calling thread is a worker of, if any. */
+static thread_local const ThreadPool* currentPool = nullptr;
+/** The index of the calling thread in currentPool. */
+static thread_local int currentWorker = -1;
+
+ThreadPool::ThreadPool(int nthreads, IdlePolicy _idlePolicy)
+        : idlePolicy(_idlePolicy), exit(false), numQueuedTasks(0),
+          numUnfinishedTasks(0), nextWorker(0) {
+    for (int i = 0; i < nthreads; i++)
+        workers.emplace_back(new WorkerThread());
+}
 
 ThreadPool::~ThreadPool() {
     // Shutdown the thread pool and free all resources.
-    for (int i = 0; i < workers.size(); i++) {
-        WorkerThread* worker = &workers[i];
-        gem5::wakeCpu(worker->cpuid);
-        pthread_mutex_lock(&worker->statusMutex);
-        worker->exit = true;
-        pthread_cond_signal(&worker->wakeupCond);
-        pthread_mutex_unlock(&worker->statusMutex);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        exit = true;
+        for (auto& worker : workers) {
+            if (worker->status != Uninitialized && idlePolicy == Quiesce)
+                gem5::wakeCpu(worker->cpuid);
+        }
+        sleepCond.notify_all();
     }
-    for (int i = 0; i < workers.size(); i++) {
-        WorkerThread* worker = &workers[i];
-        pthread_join(worker->thread, NULL);
-        pthread_mutex_destroy(&worker->statusMutex);
-        pthread_cond_destroy(&worker->wakeupCond);
-        pthread_cond_destroy(&worker->statusCond);
+    for (auto& worker : workers) {
+        if (worker->status != Uninitialized)
+            pthread_join(worker->thread, NULL);
     }
 }
 
 void* ThreadPool::workerLoop(void* args) {
     ThreadInitArgs* initArgs = reinterpret_cast<ThreadInitArgs*>(args);
-    WorkerThread* worker = initArgs->worker;
+    ThreadPool* pool = initArgs->pool;
+    int workerId = initArgs->workerId;
+    WorkerThread* worker = pool->workers[workerId].get();
+    currentPool = pool;
+    currentWorker = workerId;
     // Notify the main thread about this thread's cpuid. This can only be done
     // after the thread context is created.
     pthread_mutex_lock(&initArgs->cpuidMutex);
     initArgs->cpuid = gem5::getCpuId();
-    worker->status = Idle;
+    {
+        std::lock_guard<std::mutex> lock(pool->sleepMutex);
+        worker->status = Idle;
+    }
     pthread_cond_signal(&initArgs->cpuidCond);
     pthread_mutex_unlock(&initArgs->cpuidMutex);
 
     do {
-        gem5::quiesce();
-        pthread_mutex_lock(&worker->statusMutex);
-        while (!worker->valid && !worker->exit)
-            pthread_cond_wait(&worker->wakeupCond, &worker->statusMutex);
-        if (worker->valid) {
-            worker->status = Running;
-            pthread_mutex_unlock(&worker->statusMutex);
-
-            // Run the function.
-            worker->func(worker->args);
-
-            pthread_mutex_lock(&worker->statusMutex);
-            worker->status = Idle;
-            worker->valid = false;
-            pthread_cond_signal(&worker->statusCond);
+        Task task;
+        if (pool->popTask(task)) {
+            pool->runTask(task);
+            continue;
         }
-        bool exitThread = worker->exit;
-        pthread_mutex_unlock(&worker->statusMutex);
-        if (exitThread)
+        std::unique_lock<std::mutex> lock(pool->sleepMutex);
+        if (pool->numQueuedTasks > 0)
+            continue;
+        if (pool->exit)
             break;
+        worker->status = Idle;
+        if (pool->idlePolicy == Quiesce) {
+            lock.unlock();
+            gem5::quiesce();
+            lock.lock();
+        }
+        pool->sleepCond.wait(lock, [pool]() {
+            return pool->exit || pool->numQueuedTasks > 0;
+        });
+        worker->status = Running;
     } while (true);
 
     pthread_exit(NULL);
@@ -66,51 +83,128 @@ void* ThreadPool::workerLoop(void* args) {
 void ThreadPool::initThreadPool() {
     // Initialize the CPU ID for each worker thread.
     for (int i = 0; i < workers.size(); i++) {
-        WorkerThread* worker = &workers[i];
-        ThreadInitArgs initArgs(worker);
+        WorkerThread* worker = workers[i].get();
+        ThreadInitArgs initArgs(this, i);
         pthread_create(
                 &worker->thread, NULL, &ThreadPool::workerLoop, &initArgs);
 
         // Fill in the CPU ID of the worker thread.
         pthread_mutex_lock(&initArgs.cpuidMutex);
-        while (initArgs.cpuid == -1 || worker->status == Uninitialized)
+        while (initArgs.cpuid == -1)
             pthread_cond_wait(&initArgs.cpuidCond, &initArgs.cpuidMutex);
-        worker->cpuid = initArgs.cpuid;
         pthread_mutex_unlock(&initArgs.cpuidMutex);
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        worker->cpuid = initArgs.cpuid;
         assert(worker->status != Uninitialized &&
                "Worker thread did not successfully initialize!");
     }
 }
 
-int ThreadPool::dispatchThread(WorkerThreadFunc func, void* args) {
-    for (int i = 0; i < workers.size(); i++) {
-        WorkerThread* worker = &workers[i];
-        pthread_mutex_lock(&worker->statusMutex);
-        if (worker->status == Idle && !worker->valid) {
-            worker->func = func;
-            worker->args = args;
-            worker->valid = true;
-            gem5::wakeCpu(worker->cpuid);
-            pthread_cond_signal(&worker->wakeupCond);
-            pthread_mutex_unlock(&worker->statusMutex);
-            return i;
+int ThreadPool::currentWorkerId() const {
+    return currentPool == this ? currentWorker : -1;
+}
+
+int ThreadPool::pushTask(Task task) {
+    int workerId = currentWorkerId();
+    if (workerId == -1)
+        workerId = nextWorker++ % workers.size();
+    WorkerThread* worker = workers[workerId].get();
+    numUnfinishedTasks++;
+    {
+        std::lock_guard<std::mutex> lock(worker->tasksMutex);
+        worker->tasks.push_back(std::move(task));
+        numQueuedTasks++;
+    }
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    if (idlePolicy == Quiesce) {
+        for (auto& worker : workers) {
+            if (worker->status == Idle)
+                gem5::wakeCpu(worker->cpuid);
         }
-        pthread_mutex_unlock(&worker->statusMutex);
     }
-    return -1;
+    sleepCond.notify_all();
+    progressCond.notify_all();
+    return workerId;
 }
 
-void ThreadPool::joinThreadPool() {
-    // There is no need to call wakeCpu here. If the CPU is quiesced, then
-    // it cannot possibly be running anything, so its status will be Idle, and
-    // this will move on to the next CPU.
-    for (int i = 0; i < workers.size(); i++) {
-        WorkerThread* worker = &workers[i];
-        pthread_mutex_lock(&worker->statusMutex);
-        while (worker->status == Running || worker->valid == true)
-            pthread_cond_wait(&worker->statusCond, &worker->statusMutex);
-        pthread_mutex_unlock(&worker->statusMutex);
+bool ThreadPool::popTask(Task& task) {
+    int workerId = currentWorkerId();
+    if (workerId != -1) {
+        WorkerThread* worker = workers[workerId].get();
+        std::lock_guard<std::mutex> lock(worker->tasksMutex);
+        if (!worker->tasks.empty()) {
+            task = std::move(worker->tasks.back());
+            worker->tasks.pop_back();
+            numQueuedTasks--;
+            return true;
+        }
     }
+    // Steal from the other workers, starting from the next one.
+    for (int i = 1; i <= workers.size(); i++) {
+        int victimId = (workerId + i) % workers.size();
+        if (victimId == workerId)
+            continue;
+        WorkerThread* victim = workers[victimId].get();
+        std::lock_guard<std::mutex> lock(victim->tasksMutex);
+        if (!victim->tasks.empty()) {
+            task = std::move(victim->tasks.front());
+            victim->tasks.pop_front();
+            numQueuedTasks--;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::runTask(Task& task) {
+    task();
+    numUnfinishedTasks--;
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    progressCond.notify_all();
+}
+
+void ThreadPool::helpUntil(const std::function<bool()>& done) {
+    while (!done()) {
+        Task task;
+        if (popTask(task)) {
+            runTask(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        progressCond.wait(
+                lock, [&]() { return done() || numQueuedTasks > 0; });
+    }
+}
+
+int ThreadPool::dispatchThread(WorkerThreadFunc func, void* args) {
+    return pushTask([func, args]() { func(args); });
+}
+
+void ThreadPool::parallelFor(int begin,
+                             int end,
+                             int grainSize,
+                             const std::function<void(int, int)>& func) {
+    assert(grainSize > 0 && "The grain size must be positive!");
+    if (begin >= end)
+        return;
+    // The calling thread runs the first chunk itself.
+    std::atomic<int> numPendingChunks(0);
+    for (int chunk = begin + grainSize; chunk < end; chunk += grainSize) {
+        int chunkEnd = std::min(chunk + grainSize, end);
+        numPendingChunks++;
+        pushTask([&func, &numPendingChunks, chunk, chunkEnd]() {
+            func(chunk, chunkEnd);
+            numPendingChunks--;
+        });
+    }
+    func(begin, std::min(begin + grainSize, end));
+    helpUntil([&numPendingChunks]() { return numPendingChunks == 0; });
+}
+
+void ThreadPool::joinThreadPool() {
+    assert(currentWorkerId() == -1 &&
+           "joinThreadPool() cannot be called from a worker thread!");
+    helpUntil([this]() { return numUnfinishedTasks == 0; });
 }
 
 }  // namespace smaug
@@ -2,13 +2,20 @@
 #define _UTILITY_THREAD_POOL_H_
 
 #include <pthread.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace smaug {
 
 /**
- * A user-space cooperatve thread pool implementation designed for gem5 in SE
- * mode.
+ * A user-space work-stealing thread pool implementation designed for gem5 in
+ * SE mode.
  *
  * Multithreading in gem5 SE mode is tricky - while we can spawn pthreads, we
  * cannot let threads terminate when the pthread function returns, because the
@@ -16,24 +23,43 @@ namespace smaug {
  * that was assigned to that ThreadContext. The solution is to run an infinite
  * loop on all the threads in the pool and assign work to them from a queue.
  *
- * To prevent wasting simulation time with spinloops, this thread pool
- * implementation quiesces all inactive CPUs and wakes them up only when there
- * is work to do. This is done via magic gem5 instructions.
+ * Every worker owns a deque of tasks. A worker pushes and pops tasks at the
+ * back of its own deque, and when it runs out of work, it steals from the
+ * front of the other workers' deques. Any number of tasks can be outstanding
+ * at once, regardless of the number of workers. A thread that waits on tasks
+ * (through parallelFor(), waitFor() or joinThreadPool()) keeps executing
+ * queued tasks while it waits, so tasks may themselves submit and wait on
+ * nested tasks without deadlocking the pool.
+ *
+ * To prevent wasting simulation time with spinloops, the default Quiesce
+ * policy quiesces all inactive CPUs and wakes them up only when there is work
+ * to do. This is done via magic gem5 instructions.
  */
 class ThreadPool {
    public:
+    /** What an idle worker thread does while waiting for work. */
+    enum IdlePolicy {
+        /** Quiesce the worker's gem5 CPU, then block on a condition variable. */
+        Quiesce,
+        /** Only block on a condition variable. */
+        Block
+    };
+
     /**
      * Create a ThreadPool with N threads.
      *
      * The simulation must be created with at least N+1 CPUs, since we need one
      * CPU to run the main thread.
      */
-    ThreadPool(int nthreads);
+    ThreadPool(int nthreads, IdlePolicy _idlePolicy = Quiesce);
     ~ThreadPool();
 
     /** Function signature for any work to be executed on a worker thread. */
     typedef void* (*WorkerThreadFunc)(void*);
 
+    /** A unit of work executed by the thread pool. */
+    typedef std::function<void()> Task;
+
     /** Returns the number of worker threads. */
     int size() const { return workers.size(); }
 
@@ -47,10 +73,61 @@ class ThreadPool {
      */
     void initThreadPool();
 
-    /** Dispatch the function to a worker in the thread pool. */
+    /**
+     * Dispatch the function to a worker in the thread pool.
+     *
+     * This always succeeds and returns the index of the worker whose queue
+     * received the function; if that worker is busy, the function is either
+     * run when it gets to it or stolen by another worker.
+     */
     int dispatchThread(WorkerThreadFunc func, void* args);
 
-    /** Wait for all threads in the pool to finish work. */
+    /**
+     * Submits a callable to the thread pool and returns a future for its
+     * result. Use waitFor() rather than std::future::get() to wait on it from
+     * inside another task.
+     */
+    template <typename Func>
+    auto submit(Func&& func) -> std::future<decltype(func())> {
+        typedef decltype(func()) ResultType;
+        auto task = std::make_shared<std::packaged_task<ResultType()>>(
+                std::forward<Func>(func));
+        std::future<ResultType> future = task->get_future();
+        pushTask([task]() { (*task)(); });
+        return future;
+    }
+
+    /**
+     * Waits for the future (a std::future or std::shared_future) to become
+     * ready and returns its value, executing other queued tasks in the
+     * meantime.
+     */
+    template <typename Future>
+    auto waitFor(Future& future) -> decltype(future.get()) {
+        helpUntil([&future]() {
+            return future.wait_for(std::chrono::seconds(0)) ==
+                   std::future_status::ready;
+        });
+        return future.get();
+    }
+
+    /**
+     * Splits the range [begin, end) into chunks of at most grainSize
+     * iterations and calls func(chunkBegin, chunkEnd) for every chunk in
+     * parallel. Returns after all chunks have finished. This can be called
+     * from any thread, including from a task running on this thread pool.
+     */
+    void parallelFor(int begin,
+                     int end,
+                     int grainSize,
+                     const std::function<void(int, int)>& func);
+
+    /**
+     * Wait for all tasks in the pool to finish work.
+     *
+     * This must not be called from a task running on this thread pool, since
+     * the task would wait on itself; use parallelFor() or waitFor() instead.
+     */
     void joinThreadPool();
 
    protected:
@@ -59,54 +136,32 @@ class ThreadPool {
 
     /** All state and metadata for a worker thread. */
     struct WorkerThread {
-        WorkerThreadFunc func;
-        /** User-provided arguments. */
-        void* args;
-
         /** pthread handle. */
         pthread_t thread;
+        /** Protects the task deque. */
+        std::mutex tasksMutex;
         /**
-         * This mutex protects all of the subsequent fields of this struct. Any
-         * modification of these fields must first acquire this lock.
+         * Tasks queued on this worker. The owner works on the back of the
+         * deque, and thieves steal from the front.
          */
-        pthread_mutex_t statusMutex;
-        /** Set to true to inform the worker thread to terminate. */
-        bool exit;
-        /**  Set to true if the func and args are valid and need to be executed. */
-        bool valid;
+        std::deque<Task> tasks;
+        /** Protected by ThreadPool::sleepMutex. */
         ThreadStatus status;
-        /**
-         * The main thread signals this condition variable to wake up the
-         * thread and have it check for work (indicated by valid = true).
-         */
-        pthread_cond_t wakeupCond;
-        /** 
-         * The worker thread signals this condition variable to inform the main
-         * thread of a change in status (usually from Running -> Idle).
-         */
-        pthread_cond_t statusCond;
         /** The gem5 simulation CPU ID assigned to this worker thread. */
         int cpuid;
 
-        WorkerThread() {
-            func = NULL;
-            args = NULL;
-            exit = false;
-            valid = false;
-            status = Uninitialized;
-            pthread_mutex_init(&statusMutex, NULL);
-            pthread_cond_init(&wakeupCond, NULL);
-            pthread_cond_init(&statusCond, NULL);
-        }
+        WorkerThread() : status(Uninitialized), cpuid(-1) {}
     };
 
     struct ThreadInitArgs {
-        WorkerThread* worker;
+        ThreadPool* pool;
+        int workerId;
         pthread_mutex_t cpuidMutex;
         pthread_cond_t cpuidCond;
         int cpuid;
 
-        ThreadInitArgs(WorkerThread* _worker) : worker(_worker) {
+        ThreadInitArgs(ThreadPool* _pool, int _workerId)
+                : pool(_pool), workerId(_workerId) {
             pthread_mutex_init(&cpuidMutex, NULL);
             pthread_cond_init(&cpuidCond, NULL);
             cpuid = -1;
@@ -116,8 +171,54 @@ class ThreadPool {
     /** The main event loop executed by all worker threads. */
     static void* workerLoop(void* args);
 
+    /**
+     * Queues a task. Tasks submitted from a worker of this pool go on that
+     * worker's own deque; otherwise, workers are picked round-robin. Returns
+     * the index of the chosen worker.
+     */
+    int pushTask(Task task);
+
+    /**
+     * Takes a task off the calling worker's own deque, or steals one from
+     * another worker. Returns false if there are no queued tasks.
+     */
+    bool popTask(Task& task);
+
+    /** Runs the task and wakes up any thread waiting on its completion. */
+    void runTask(Task& task);
+
+    /** Executes queued tasks until done() returns true. */
+    void helpUntil(const std::function<bool()>& done);
+
+    /**
+     * Returns the index of the calling thread in this pool, or -1 if the
+     * caller is not one of its workers.
+     */
+    int currentWorkerId() const;
+
     /** Worker threads. */
-    std::vector<WorkerThread> workers;
+    std::vector<std::unique_ptr<WorkerThread>> workers;
+
+    IdlePolicy idlePolicy;
+
+    /**
+     * Protects the worker statuses and the exit flag. Waiting threads block
+     * on the condition variables with this mutex held.
+     */
+    std::mutex sleepMutex;
+    /** Idle workers wait on this for new tasks. */
+    std::condition_variable sleepCond;
+    /** Threads waiting in helpUntil() wait on this for any progress. */
+    std::condition_variable progressCond;
+    /** Set to true to inform the worker threads to terminate. */
+    bool exit;
+
+    /** The number of tasks sitting in the worker deques. */
+    std::atomic<int> numQueuedTasks;
+    /** The number of tasks that have been submitted but not finished. */
+    std::atomic<int> numUnfinishedTasks;
+    /** The worker that gets the next task submitted from outside the pool. */
+    std::atomic<unsigned> nextWorker;
 };
 
 }  // namespace smaug
@@ -0,0 +1,68 @@
+#include <atomic>
+#include <vector>
+
+#include "catch.hpp"
+#include "smaug/utility/thread_pool.h"
+
+using namespace smaug;
+
+static std::atomic<int> numCalls;
+
+static void* incrementWorker(void* args) {
+    numCalls++;
+    *reinterpret_cast<int*>(args) += 1;
+    return nullptr;
+}
+
+TEST_CASE("Work-stealing thread pool", "[threadpool]") {
+    ThreadPool pool(3, ThreadPool::Block);
+    pool.initThreadPool();
+
+    SECTION("Dispatch more tasks than threads") {
+        numCalls = 0;
+        std::vector<int> counters(64, 0);
+        for (int i = 0; i < counters.size(); i++)
+            REQUIRE(pool.dispatchThread(incrementWorker, &counters[i]) != -1);
+        pool.joinThreadPool();
+        REQUIRE(numCalls == counters.size());
+        for (int counter : counters)
+            REQUIRE(counter == 1);
+    }
+
+    SECTION("Futures") {
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 16; i++)
+            futures.push_back(pool.submit([i]() { return i * i; }));
+        for (int i = 0; i < 16; i++)
+            REQUIRE(pool.waitFor(futures[i]) == i * i);
+    }
+
+    SECTION("Nested parallelFor") {
+        const int kOuter = 12, kInner = 100;
+        std::vector<std::atomic<int>> sums(kOuter);
+        for (auto& sum : sums)
+            sum = 0;
+        pool.parallelFor(0, kOuter, 1, [&](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                pool.parallelFor(0, kInner, 7, [&](int b, int e) {
+                    for (int j = b; j < e; j++)
+                        sums[i] += j;
+                });
+            }
+        });
+        for (auto& sum : sums)
+            REQUIRE(sum == kInner * (kInner - 1) / 2);
+    }
+
+    SECTION("Tasks waiting on nested futures") {
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 8; i++) {
+            futures.push_back(pool.submit([&pool, i]() {
+                auto inner = pool.submit([i]() { return i + 1; });
+                return pool.waitFor(inner) * 2;
+            }));
+        }
+        for (int i = 0; i < 8; i++)
+            REQUIRE(pool.waitFor(futures[i]) == (i + 1) * 2);
+    }
+}